@@ -0,0 +1,69 @@
+#include "benchmarkrunner.h"
+#include <QtCore/QDebug>
+#include <QtCore/QJsonArray>
+
+const volatile void *BenchmarkRunner::_sink = nullptr;
+
+double BenchmarkRunner::Result::nsPerOp() const
+{
+	return static_cast<double>(elapsedNs) / static_cast<double>(iterations);
+}
+
+double BenchmarkRunner::Result::bytesPerSecond() const
+{
+	return bytesPerOp == 0 ?
+				0.0 :
+				static_cast<double>(bytesPerOp) * 1e9 / nsPerOp();
+}
+
+BenchmarkRunner::BenchmarkRunner(std::chrono::milliseconds minTime, QString filter) :
+	_minTime{minTime},
+	_filter{std::move(filter)}
+{}
+
+bool BenchmarkRunner::isSelected(const QString &name) const
+{
+	return _filter.isEmpty() || name.contains(_filter);
+}
+
+QList<BenchmarkRunner::Result> BenchmarkRunner::results() const
+{
+	return _results;
+}
+
+QJsonDocument BenchmarkRunner::toJson(QJsonObject info) const
+{
+	QJsonArray results;
+	for(const auto &result : _results) {
+		QJsonObject jResult;
+		jResult[QStringLiteral("name")] = result.name;
+		jResult[QStringLiteral("iterations")] = result.iterations;
+		jResult[QStringLiteral("nsPerOp")] = result.nsPerOp();
+		if(result.bytesPerOp != 0) {
+			jResult[QStringLiteral("bytesPerOp")] = result.bytesPerOp;
+			jResult[QStringLiteral("bytesPerSecond")] = result.bytesPerSecond();
+		}
+		results.append(jResult);
+	}
+	info[QStringLiteral("results")] = results;
+	return QJsonDocument{info};
+}
+
+QByteArray BenchmarkRunner::toCsv() const
+{
+	QByteArray csv = "name,iterations,nsPerOp,bytesPerOp,bytesPerSecond\n";
+	for(const auto &result : _results) {
+		csv += result.name.toUtf8() + ',' +
+			   QByteArray::number(result.iterations) + ',' +
+			   QByteArray::number(result.nsPerOp(), 'f', 2) + ',' +
+			   QByteArray::number(result.bytesPerOp) + ',' +
+			   QByteArray::number(result.bytesPerSecond(), 'f', 0) + '\n';
+	}
+	return csv;
+}
+
+void BenchmarkRunner::report(Result &&result)
+{
+	qInfo().noquote() << result.name << QString::number(result.nsPerOp(), 'f', 2) << "ns/op";
+	_results.append(std::move(result));
+}
@@ -0,0 +1,77 @@
+#ifndef KPXCCLIENT_BENCHMARKRUNNER_H
+#define KPXCCLIENT_BENCHMARKRUNNER_H
+
+#include <chrono>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+class BenchmarkRunner
+{
+public:
+	struct Result {
+		QString name;
+		qint64 iterations = 0;
+		qint64 elapsedNs = 0;
+		qint64 bytesPerOp = 0;
+
+		double nsPerOp() const;
+		double bytesPerSecond() const;
+	};
+
+	explicit BenchmarkRunner(std::chrono::milliseconds minTime, QString filter = {});
+
+	bool isSelected(const QString &name) const;
+
+	// runs func in growing batches until a batch takes at least minTime
+	template <typename TFunc>
+	void run(const QString &name, TFunc &&func, qint64 bytesPerOp = 0);
+
+	QList<Result> results() const;
+	QJsonDocument toJson(QJsonObject info = {}) const;
+	QByteArray toCsv() const;
+
+	template <typename T>
+	static void keep(const T &value);
+
+private:
+	std::chrono::nanoseconds _minTime;
+	QString _filter;
+	QList<Result> _results;
+
+	static const volatile void *_sink;
+
+	void report(Result &&result);
+};
+
+template <typename TFunc>
+void BenchmarkRunner::run(const QString &name, TFunc &&func, qint64 bytesPerOp)
+{
+	if(!isSelected(name))
+		return;
+
+	func(); // warm up
+	QElapsedTimer timer;
+	for(qint64 iterations = 1; ; iterations *= 2) {
+		timer.start();
+		for(qint64 i = 0; i < iterations; ++i)
+			func();
+		const auto elapsed = timer.nsecsElapsed();
+		if(elapsed >= _minTime.count()) {
+			report({name, iterations, elapsed, bytesPerOp});
+			return;
+		}
+	}
+}
+
+template <typename T>
+void BenchmarkRunner::keep(const T &value)
+{
+	// prevents the compiler from dropping the benchmarked call
+	_sink = &value;
+}
+
+#endif // KPXCCLIENT_BENCHMARKRUNNER_H
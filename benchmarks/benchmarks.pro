@@ -0,0 +1,39 @@
+TEMPLATE = app
+
+QT = core network
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = $${TARGET_BASE}-benchmarks
+QMAKE_TARGET_DESCRIPTION = "KeePassXC Client Library Benchmarks"
+DEFINES += "KPXCCLIENT_VERSION=\\\"$$VERSION\\\""
+
+HEADERS += \
+	benchmarkrunner.h
+
+SOURCES += \
+	main.cpp \
+	benchmarkrunner.cpp
+
+# mock server lib
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../mockserver/lib/release/ -l$${TARGET_BASE}-mockserver
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../mockserver/lib/debug/ -l$${TARGET_BASE}-mockserver
+else: LIBS += -L$$OUT_PWD/../mockserver/lib/ -l$${TARGET_BASE}-mockserver
+
+INCLUDEPATH += $$PWD/../mockserver/lib
+DEPENDPATH += $$PWD/../mockserver/lib
+
+# lib - the benchmarks use the private API as well
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../src/release/ -lkpxcclient
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../src/debug/ -lkpxcclient
+else:mac: LIBS += -F$$OUT_PWD/../src/ -framework kpxcclient
+else:unix: LIBS += -L$$OUT_PWD/../src/ -lkpxcclient
+
+INCLUDEPATH += $$PWD/../src
+DEPENDPATH += $$PWD/../src
+
+unix {
+	CONFIG += link_pkgconfig
+	PKGCONFIG += libsodium
+}
@@ -0,0 +1,360 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+
+#include <client.h>
+#include <loopbackserver.h>
+#include <mockserver.h>
+#include <client_p.h>
+#include <sodiumcryptor_p.h>
+#include <envelopeencoder_p.h>
+#include <envelopedecoder_p.h>
+#include <jsonwriter_p.h>
+
+#include <sodium/core.h>
+#include <sodium/version.h>
+
+#include "benchmarkrunner.h"
+
+using namespace KPXCClient;
+
+namespace {
+
+const QList<int> EntryCounts{1, 100, 10000};
+const QList<int> PayloadSizes{64, 1024, 64 * 1024};
+
+QJsonObject getLoginsPayload(int entryCount)
+{
+	QJsonArray entries;
+	for(auto i = 0; i < entryCount; ++i) {
+		QJsonObject entry;
+		entry[QStringLiteral("uuid")] = QStringLiteral("%1").arg(i, 32, 16, QLatin1Char('0'));
+		entry[QStringLiteral("name")] = QStringLiteral("example.com #%1").arg(i);
+		entry[QStringLiteral("login")] = QStringLiteral("user%1").arg(i);
+		entry[QStringLiteral("password")] = QStringLiteral("Zm9vYmFyYmF6cXV4cXV1eC0%1").arg(i);
+		entry[QStringLiteral("totp")] = QString{};
+		entry[QStringLiteral("stringFields")] = QJsonArray{};
+		entries.append(entry);
+	}
+
+	QJsonObject message;
+	message[QStringLiteral("version")] = QStringLiteral("2.7.0");
+	message[QStringLiteral("success")] = QStringLiteral("true");
+	message[QStringLiteral("hash")] = QStringLiteral("29234e32274a32276e25666a4229234e32274a32276e25666a42");
+	message[QStringLiteral("count")] = entryCount;
+	message[QStringLiteral("entries")] = entries;
+	return message;
+}
+
+template <typename T>
+T waitFor(const QFuture<T> &future)
+{
+	while(!future.isFinished())
+		QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+	return future.result();
+}
+
+void benchCrypto(BenchmarkRunner &runner)
+{
+	SodiumCryptor cryptor;
+	SodiumCryptor peer;
+	cryptor.createKeys();
+	peer.createKeys();
+
+	runner.run(QStringLiteral("sodium/generateRandomNonce"), [&]() {
+		BenchmarkRunner::keep(cryptor.generateRandomNonce());
+	});
+
+	SodiumCryptor buffered;
+	buffered.setBufferedRandom(true);
+	runner.run(QStringLiteral("sodium/generateRandomNonce-buffered"), [&]() {
+		BenchmarkRunner::keep(buffered.generateRandomNonce());
+	});
+
+	const auto nonce = cryptor.generateRandomNonce(SecureByteArray::State::Readonly);
+	cryptor.precompute(peer.publicKey());
+	peer.precompute(cryptor.publicKey());
+	for(const auto size : PayloadSizes) {
+		const QByteArray plain{size, 'x'};
+		runner.run(QStringLiteral("sodium/encrypt/%1").arg(size), [&]() {
+			BenchmarkRunner::keep(cryptor.encrypt(plain, peer.publicKey(), nonce));
+		}, size);
+
+		const auto cipher = peer.encrypt(plain, cryptor.publicKey(), nonce);
+		runner.run(QStringLiteral("sodium/decrypt/%1").arg(size), [&]() {
+			BenchmarkRunner::keep(cryptor.decrypt(cipher, peer.publicKey(), nonce));
+		}, size);
+
+		runner.run(QStringLiteral("sodium/encrypt-afternm/%1").arg(size), [&]() {
+			BenchmarkRunner::keep(cryptor.encrypt(plain, nonce.constData()));
+		}, size);
+		runner.run(QStringLiteral("sodium/decrypt-afternm/%1").arg(size), [&]() {
+			BenchmarkRunner::keep(cryptor.decrypt(cipher, nonce.constData()));
+		}, size);
+	}
+}
+
+void benchEnvelope(BenchmarkRunner &runner)
+{
+	SodiumCryptor cryptor;
+	SodiumCryptor peer;
+	cryptor.createKeys();
+	peer.createKeys();
+	cryptor.precompute(peer.publicKey());
+	const auto nonce = cryptor.generateRandomNonce(SecureByteArray::State::Readonly);
+	const auto clientId = cryptor.generateRandomNonce(SecureByteArray::State::Readonly);
+	const auto action = QStringLiteral("get-logins");
+
+	FrameQueue queue;
+	for(const auto size : PayloadSizes) {
+		const QByteArray plain{size, 'x'};
+		// the envelope as it was built before the single pass encoder
+		runner.run(QStringLiteral("envelope/encode-json/%1").arg(size), [&]() {
+			QJsonObject envelope;
+			envelope[QStringLiteral("action")] = action;
+			envelope[QStringLiteral("message")] = QString::fromUtf8(cryptor.encrypt(plain, nonce.constData()).toBase64());
+			envelope[QStringLiteral("nonce")] = nonce.toBase64();
+			envelope[QStringLiteral("clientID")] = clientId.toBase64();
+			envelope[QStringLiteral("triggerUnlock")] = QStringLiteral("false");
+			queue.enqueue(QJsonDocument{envelope}.toJson(QJsonDocument::Compact));
+			BenchmarkRunner::keep(queue.gather());
+		}, size);
+		runner.run(QStringLiteral("envelope/encode/%1").arg(size), [&]() {
+			auto message = plain;
+			EnvelopeEncoder::encode(queue, &cryptor, action, message, nonce, clientId, false);
+			BenchmarkRunner::keep(queue.gather());
+		}, size);
+
+		QJsonObject reply;
+		reply[QStringLiteral("action")] = action;
+		reply[QStringLiteral("message")] = QString::fromUtf8(cryptor.encrypt(plain, nonce.constData()).toBase64());
+		reply[QStringLiteral("nonce")] = nonce.toBase64();
+		reply[QStringLiteral("version")] = QStringLiteral("2.7.9");
+		reply[QStringLiteral("success")] = QStringLiteral("true");
+		const auto frame = QJsonDocument{reply}.toJson(QJsonDocument::Compact);
+		runner.run(QStringLiteral("envelope/decode-json/%1").arg(size), [&]() {
+			BenchmarkRunner::keep(QJsonDocument::fromJson(frame).object());
+		}, frame.size());
+		runner.run(QStringLiteral("envelope/decode/%1").arg(size), [&]() {
+			EnvelopeDecoder::Envelope envelope;
+			EnvelopeDecoder::decode(frame, envelope);
+			BenchmarkRunner::keep(envelope.message);
+		}, frame.size());
+	}
+}
+
+void benchSecureByteArray(BenchmarkRunner &runner)
+{
+	runner.run(QStringLiteral("securebytearray/alloc/32"), []() {
+		SecureByteArray data{32};
+		BenchmarkRunner::keep(data);
+	});
+
+	SecureByteArray source{32};
+	runner.run(QStringLiteral("securebytearray/copy/32"), [&]() {
+		// writing detaches the shared copy
+		SecureByteArray copy{source};
+		BenchmarkRunner::keep(copy.data());
+	});
+
+	SecureByteArray data{32};
+	runner.run(QStringLiteral("securebytearray/setState"), [&]() {
+		data.makeNoaccess();
+		data.makeReadonly();
+		data.makeReadwrite();
+	});
+
+	// a key read by a burst of 16 messages
+	SecureByteArray key{32, SecureByteArray::State::Noaccess};
+	runner.run(QStringLiteral("securebytearray/stateLocker-strict/16"), [&]() {
+		for(auto i = 0; i < 16; ++i) {
+			SecureByteArray::StateLocker _{&key, SecureByteArray::State::Readonly};
+			BenchmarkRunner::keep(key.constData());
+		}
+	});
+	runner.run(QStringLiteral("securebytearray/readLocker/16"), [&]() {
+		for(auto i = 0; i < 16; ++i) {
+			SecureByteArray::ReadLocker _{key};
+			BenchmarkRunner::keep(key.constData());
+		}
+	});
+	runner.run(QStringLiteral("securebytearray/stateLocker-epoch/16"), [&]() {
+		const SecureByteArray::AccessEpoch epoch;
+		for(auto i = 0; i < 16; ++i) {
+			SecureByteArray::StateLocker _{&key, SecureByteArray::State::Readonly};
+			BenchmarkRunner::keep(key.constData());
+		}
+	});
+}
+
+void benchBase64(BenchmarkRunner &runner)
+{
+	for(const auto size : PayloadSizes) {
+		const QByteArray plain{size, 'x'};
+		runner.run(QStringLiteral("base64/encode/%1").arg(size), [&]() {
+			BenchmarkRunner::keep(plain.toBase64());
+		}, size);
+
+		const auto encoded = plain.toBase64();
+		runner.run(QStringLiteral("base64/decode/%1").arg(size), [&]() {
+			BenchmarkRunner::keep(QByteArray::fromBase64(encoded));
+		}, size);
+	}
+}
+
+void benchJson(BenchmarkRunner &runner)
+{
+	for(const auto count : EntryCounts) {
+		const auto message = getLoginsPayload(count);
+		const auto json = QJsonDocument{message}.toJson(QJsonDocument::Compact);
+		runner.run(QStringLiteral("json/serialize/get-logins/%1").arg(count), [&]() {
+			BenchmarkRunner::keep(QJsonDocument{message}.toJson(QJsonDocument::Compact));
+		}, json.size());
+		runner.run(QStringLiteral("json/write/get-logins/%1").arg(count), [&]() {
+			BenchmarkRunner::keep(JsonWriter::toJson(message));
+		}, json.size());
+		runner.run(QStringLiteral("json/parse/get-logins/%1").arg(count), [&]() {
+			BenchmarkRunner::keep(QJsonDocument::fromJson(json).object());
+		}, json.size());
+
+		// entry materialization of ClientPrivate::onGetLogins
+		runner.run(QStringLiteral("client/readEntries/%1").arg(count), [&]() {
+			BenchmarkRunner::keep(ClientPrivate::readEntries(message));
+		});
+	}
+}
+
+void benchLoopback(BenchmarkRunner &runner)
+{
+	if(!runner.isSelected(QStringLiteral("loopback/")))
+		return;
+
+	LoopbackServer loopback;
+	MockServer mock;
+	mock.attach(&loopback);
+
+	Client client;
+	auto failed = false;
+	QObject::connect(&client, &Client::errorOccured,
+					 [&](Client::Error error, const QString &message) {
+		qCritical() << "Loopback benchmark failed with" << error << message;
+		failed = true;
+	});
+	client.connectToLoopback(&loopback);
+	while(!failed && client.state() != Client::State::Unlocked)
+		QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+	if(failed)
+		return;
+
+	runner.run(QStringLiteral("loopback/generatePassword"), [&]() {
+		BenchmarkRunner::keep(waitFor(client.generatePasswordAsync()));
+	});
+	for(const auto count : EntryCounts) {
+		mock.setEntryCount(count);
+		runner.run(QStringLiteral("loopback/getLogins/%1").arg(count), [&]() {
+			BenchmarkRunner::keep(waitFor(client.getLoginsAsync(QStringLiteral("https://example.com"))));
+		});
+	}
+
+	// a batch against the sequential requests it replaces
+	mock.setEntryCount(1);
+	QList<QUrl> urls;
+	for(auto i = 0; i < 100; ++i)
+		urls.append(QUrl{QStringLiteral("https://host%1.example.com").arg(i)});
+	runner.run(QStringLiteral("loopback/getLogins-sequential/100"), [&]() {
+		for(const auto &url : qAsConst(urls))
+			BenchmarkRunner::keep(waitFor(client.getLoginsAsync(url)));
+	});
+	runner.run(QStringLiteral("loopback/getLoginsBatch/100"), [&]() {
+		BenchmarkRunner::keep(waitFor(client.getLoginsBatchAsync(urls)));
+	});
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName(QStringLiteral("kpxcclient-benchmarks"));
+	QCoreApplication::setApplicationVersion(QStringLiteral(KPXCCLIENT_VERSION));
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QStringLiteral("Microbenchmarks for the per message costs of the library."));
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addOption({
+		{QStringLiteral("f"), QStringLiteral("filter")},
+		QStringLiteral("Only run benchmarks whose name contains <text>."),
+		QStringLiteral("text")
+	});
+	parser.addOption({
+		{QStringLiteral("t"), QStringLiteral("min-time")},
+		QStringLiteral("Run every benchmark for at least <msecs> milliseconds (default: 200)."),
+		QStringLiteral("msecs"),
+		QStringLiteral("200")
+	});
+	parser.addOption({
+		QStringLiteral("format"),
+		QStringLiteral("The output <format>, either json or csv (default: json)."),
+		QStringLiteral("format"),
+		QStringLiteral("json")
+	});
+	parser.addOption({
+		{QStringLiteral("o"), QStringLiteral("output")},
+		QStringLiteral("Write the results to <file> instead of stdout."),
+		QStringLiteral("file")
+	});
+	parser.process(a);
+
+	if(!KPXCClient::init()) {
+		qCritical() << "Failed to initialize libsodium";
+		return EXIT_FAILURE;
+	}
+
+	BenchmarkRunner runner{
+		std::chrono::milliseconds{parser.value(QStringLiteral("min-time")).toInt()},
+		parser.value(QStringLiteral("filter"))
+	};
+	benchCrypto(runner);
+	benchEnvelope(runner);
+	benchSecureByteArray(runner);
+	benchBase64(runner);
+	benchJson(runner);
+	benchLoopback(runner);
+
+	QByteArray output;
+	if(parser.value(QStringLiteral("format")) == QStringLiteral("csv"))
+		output = runner.toCsv();
+	else {
+		QJsonObject info;
+		info[QStringLiteral("library")] = QStringLiteral("kpxcclient");
+		info[QStringLiteral("version")] = QCoreApplication::applicationVersion();
+		info[QStringLiteral("qt")] = QString::fromUtf8(qVersion());
+		info[QStringLiteral("sodium")] = QString::fromUtf8(sodium_version_string());
+		const auto memory = SecureByteArray::memoryStatistics();
+		info[QStringLiteral("secureMemory")] = QJsonObject{
+			{QStringLiteral("peakBytesRequested"), static_cast<double>(memory.peakBytesRequested)},
+			{QStringLiteral("peakPagesLocked"), static_cast<double>(memory.peakPagesLocked)},
+			{QStringLiteral("totalAllocations"), static_cast<double>(memory.totalAllocations)},
+			{QStringLiteral("mprotectCalls"), static_cast<double>(memory.mprotectCalls)}
+		};
+		output = runner.toJson(info).toJson(QJsonDocument::Indented);
+	}
+
+	QFile file;
+	if(parser.isSet(QStringLiteral("output"))) {
+		file.setFileName(parser.value(QStringLiteral("output")));
+		if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			qCritical() << "Failed to open output file with error:" << file.errorString();
+			return EXIT_FAILURE;
+		}
+	} else if(!file.open(stdout, QIODevice::WriteOnly)) {
+		qCritical() << "Failed to open stdout with error:" << file.errorString();
+		return EXIT_FAILURE;
+	}
+	file.write(output);
+	return EXIT_SUCCESS;
+}
@@ -1,9 +1,18 @@
 TEMPLATE = subdirs
 
 SUBDIRS += src \
-	clidemo
+	clidemo \
+	mockserver
 
 clidemo.depends += src
+mockserver.depends += src
+
+# the benchmarks and tests link against symbols that are only exported on unix
+unix {
+	SUBDIRS += benchmarks tests
+	benchmarks.depends += src mockserver
+	tests.depends += src mockserver
+}
 
 DISTFILES += \
 	.qmake.conf \
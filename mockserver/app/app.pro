@@ -0,0 +1,34 @@
+TEMPLATE = app
+
+QT = core network
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = $${TARGET_BASE}-mockserver
+QMAKE_TARGET_DESCRIPTION = "KeePassXC Mock Server"
+
+SOURCES += \
+	main.cpp
+
+# mock server lib
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../lib/release/ -l$${TARGET_BASE}-mockserver
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../lib/debug/ -l$${TARGET_BASE}-mockserver
+else: LIBS += -L$$OUT_PWD/../lib/ -l$${TARGET_BASE}-mockserver
+
+INCLUDEPATH += $$PWD/../lib
+DEPENDPATH += $$PWD/../lib
+
+# lib
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../../src/release/ -lkpxcclient
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../../src/debug/ -lkpxcclient
+else:mac: LIBS += -F$$OUT_PWD/../../src/ -framework kpxcclient
+else:unix: LIBS += -L$$OUT_PWD/../../src/ -lkpxcclient
+
+INCLUDEPATH += $$PWD/../../src
+DEPENDPATH += $$PWD/../../src
+
+unix {
+	CONFIG += link_pkgconfig
+	PKGCONFIG += libsodium
+}
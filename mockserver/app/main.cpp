@@ -0,0 +1,65 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <kpxcclient_global.h>
+#include <mockserver.h>
+
+#include <QDebug>
+
+using namespace KPXCClient;
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName(QStringLiteral("kpxcclient-mockserver"));
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QStringLiteral("A headless stand-in for KeePassXC. "
+													"Without --listen, it speaks the keepassxc-proxy protocol on stdin/stdout."));
+	parser.addHelpOption();
+	parser.addOption({
+		{QStringLiteral("l"), QStringLiteral("listen")},
+		QStringLiteral("Listen on the local socket <name> instead of stdin/stdout."),
+		QStringLiteral("name")
+	});
+	parser.addOption({
+		{QStringLiteral("n"), QStringLiteral("entries")},
+		QStringLiteral("Create <count> synthetic entries for every requested host (default: 10)."),
+		QStringLiteral("count"),
+		QStringLiteral("10")
+	});
+	parser.addOption({
+		{QStringLiteral("d"), QStringLiteral("delay")},
+		QStringLiteral("Delay every reply by <msecs> milliseconds (default: 0)."),
+		QStringLiteral("msecs"),
+		QStringLiteral("0")
+	});
+	parser.addOption({
+		QStringLiteral("locked"),
+		QStringLiteral("Start with a locked database.")
+	});
+	parser.process(a);
+
+	if(!KPXCClient::init()) {
+		qCritical() << "Failed to initialize libsodium";
+		return EXIT_FAILURE;
+	}
+
+	MockServer server;
+	server.setEntryCount(parser.value(QStringLiteral("entries")).toInt());
+	server.setReplyDelay(parser.value(QStringLiteral("delay")).toInt());
+	server.setLocked(parser.isSet(QStringLiteral("locked")));
+
+	if(parser.isSet(QStringLiteral("listen"))) {
+		if(!server.listen(parser.value(QStringLiteral("listen"))))
+			return EXIT_FAILURE;
+	} else {
+		if(!server.attachStdio()) {
+			qCritical() << "stdin/stdout mode is not supported on this platform";
+			return EXIT_FAILURE;
+		}
+		QObject::connect(&server, &MockServer::stdioClosed,
+						 &a, &QCoreApplication::quit);
+	}
+
+	return a.exec();
+}
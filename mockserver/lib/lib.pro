@@ -0,0 +1,21 @@
+TEMPLATE = lib
+
+QT = core network
+
+CONFIG += staticlib
+
+TARGET = $${TARGET_BASE}-mockserver
+QMAKE_TARGET_DESCRIPTION = "KeePassXC Mock Server"
+
+INCLUDEPATH += $$PWD/../../src
+
+HEADERS += \
+	mockserver.h
+
+SOURCES += \
+	mockserver.cpp
+
+unix {
+	CONFIG += link_pkgconfig
+	PKGCONFIG += libsodium
+}
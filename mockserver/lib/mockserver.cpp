@@ -0,0 +1,522 @@
+#include "mockserver.h"
+#include <loopbackserver.h>
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QPointer>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
+#include <QtCore/QUrl>
+#include <QtCore/QtEndian>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+#include <sodium/crypto_box.h>
+#include <sodium/crypto_generichash.h>
+#include <sodium/randombytes.h>
+#include <sodium/utils.h>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+using namespace KPXCClient;
+
+namespace {
+
+constexpr int HeaderSize = sizeof(quint32);
+
+// KeePassXC reads plain JSON objects from its socket, so a frame ends with the closing brace
+int jsonObjectEnd(const QByteArray &buffer)
+{
+	auto depth = 0;
+	auto inString = false;
+	auto escaped = false;
+	for(auto i = 0; i < buffer.size(); ++i) {
+		const auto c = buffer[i];
+		if(inString) {
+			if(escaped)
+				escaped = false;
+			else if(c == '\\')
+				escaped = true;
+			else if(c == '"')
+				inString = false;
+		} else if(c == '"')
+			inString = true;
+		else if(c == '{' || c == '[')
+			++depth;
+		else if((c == '}' || c == ']') && --depth == 0)
+			return i + 1;
+	}
+	return -1;
+}
+
+}
+
+const QString MockServer::Version{QStringLiteral("2.7.0")};
+
+MockServer::MockServer(QObject *parent) :
+	QObject{parent},
+	_publicKey{crypto_box_PUBLICKEYBYTES, Qt::Uninitialized},
+	_secretKey{crypto_box_SECRETKEYBYTES, Qt::Uninitialized},
+	_databaseHash{32, Qt::Uninitialized}
+{
+	crypto_box_keypair(reinterpret_cast<unsigned char*>(_publicKey.data()),
+					   reinterpret_cast<unsigned char*>(_secretKey.data()));
+	randombytes_buf(_databaseHash.data(), static_cast<size_t>(_databaseHash.size()));
+}
+
+MockServer::~MockServer()
+{
+	sodium_memzero(_secretKey.data(), static_cast<size_t>(_secretKey.size()));
+}
+
+int MockServer::entryCount() const
+{
+	return _entryCount;
+}
+
+int MockServer::replyDelay() const
+{
+	return _replyDelay;
+}
+
+bool MockServer::isLocked() const
+{
+	return _locked;
+}
+
+QByteArray MockServer::databaseHash() const
+{
+	return _databaseHash;
+}
+
+int MockServer::requestCount() const
+{
+	return _requestCount;
+}
+
+bool MockServer::listen(const QString &serverName)
+{
+	if(_localServer)
+		return false;
+
+	QLocalServer::removeServer(serverName);
+	_localServer = new QLocalServer{this};
+	if(!_localServer->listen(serverName)) {
+		qCritical() << "Failed to listen on" << serverName << "with error:" << _localServer->errorString();
+		_localServer->deleteLater();
+		_localServer = nullptr;
+		return false;
+	}
+
+	connect(_localServer, &QLocalServer::newConnection,
+			this, [this]() {
+		while(const auto socket = _localServer->nextPendingConnection()) {
+			const auto session = createSession(Framing::JsonStream, [socket{QPointer<QLocalSocket>{socket}}](const QByteArray &data) {
+				if(socket)
+					socket->write(data);
+			});
+			connect(socket, &QLocalSocket::readyRead,
+					this, [this, socket, session]() {
+				receive(session, socket->readAll());
+			});
+			connect(socket, &QLocalSocket::disconnected,
+					this, [this, socket, session]() {
+				removeSession(session);
+				socket->deleteLater();
+			});
+		}
+	});
+	return true;
+}
+
+void MockServer::attach(LoopbackServer *server)
+{
+	const auto session = createSession(Framing::Message, [server{QPointer<LoopbackServer>{server}}](const QByteArray &data) {
+		if(server)
+			server->sendMessage(data);
+	});
+	connect(server, &LoopbackServer::messageReceived,
+			this, [this, session](const QByteArray &message) {
+		receive(session, message);
+	});
+	// a loopback server is reused for every client that connects to it
+	connect(server, &LoopbackServer::connectedChanged,
+			this, [session]() {
+		session->buffer.clear();
+		session->clientKey.clear();
+	});
+	connect(server, &QObject::destroyed,
+			this, [this, session]() {
+		removeSession(session);
+	});
+}
+
+bool MockServer::attachStdio()
+{
+#ifdef Q_OS_UNIX
+	if(_stdinNotifier)
+		return false;
+
+	// behave like keepassxc-proxy, so the executable can be used as proxy path
+	_stdout = new QFile{this};
+	if(!_stdout->open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+		qCritical() << "Failed to open stdout with error:" << _stdout->errorString();
+		return false;
+	}
+
+	const auto session = createSession(Framing::LengthPrefixed, [this](const QByteArray &data) {
+		_stdout->write(data);
+	});
+	_stdinNotifier = new QSocketNotifier{STDIN_FILENO, QSocketNotifier::Read, this};
+	connect(_stdinNotifier, &QSocketNotifier::activated,
+			this, [this, session]() {
+		char buffer[16 * 1024];
+		const auto bytesRead = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+		if(bytesRead <= 0) {
+			_stdinNotifier->setEnabled(false);
+			removeSession(session);
+			emit stdioClosed();
+		} else
+			receive(session, QByteArray{buffer, static_cast<int>(bytesRead)});
+	});
+	return true;
+#else
+	return false;
+#endif
+}
+
+void MockServer::setEntryCount(int entryCount)
+{
+	if(_entryCount == entryCount)
+		return;
+
+	_entryCount = entryCount;
+	_entries.clear();
+	emit entryCountChanged(_entryCount);
+}
+
+void MockServer::setReplyDelay(int replyDelay)
+{
+	if(_replyDelay == replyDelay)
+		return;
+
+	_replyDelay = replyDelay;
+	emit replyDelayChanged(_replyDelay);
+}
+
+void MockServer::setLocked(bool locked)
+{
+	if(_locked == locked)
+		return;
+
+	_locked = locked;
+	emit lockedChanged(_locked);
+	broadcast(_locked ?
+				  QStringLiteral("database-locked") :
+				  QStringLiteral("database-unlocked"));
+}
+
+MockServer::SessionPtr MockServer::createSession(Framing framing, std::function<void(const QByteArray &)> write)
+{
+	SessionPtr session{new Session{framing, std::move(write), {}, {}}};
+	_sessions.append(session);
+	return session;
+}
+
+void MockServer::removeSession(const SessionPtr &session)
+{
+	_sessions.removeOne(session);
+	session->write = [](const QByteArray &) {};
+}
+
+void MockServer::receive(const SessionPtr &session, const QByteArray &data)
+{
+	QList<QByteArray> frames;
+	switch(session->framing) {
+	case Framing::Message:
+		frames.append(data);
+		break;
+	case Framing::LengthPrefixed:
+		session->buffer.append(data);
+		while(session->buffer.size() >= HeaderSize) {
+			const auto size = static_cast<int>(qFromUnaligned<quint32>(session->buffer.constData()));
+			if(session->buffer.size() - HeaderSize < size)
+				break;
+			frames.append(session->buffer.mid(HeaderSize, size));
+			session->buffer.remove(0, HeaderSize + size);
+		}
+		break;
+	case Framing::JsonStream:
+		session->buffer.append(data);
+		for(auto end = jsonObjectEnd(session->buffer); end != -1; end = jsonObjectEnd(session->buffer)) {
+			frames.append(session->buffer.left(end));
+			session->buffer.remove(0, end);
+		}
+		break;
+	default:
+		Q_UNREACHABLE();
+		break;
+	}
+
+	for(const auto &frame : qAsConst(frames)) {
+		QJsonParseError error;
+		const auto request = QJsonDocument::fromJson(frame, &error).object();
+		if(error.error != QJsonParseError::NoError) {
+			qWarning() << "Ignoring invalid request:" << error.errorString();
+			continue;
+		}
+		send(session, handleRequest(*session, request));
+	}
+}
+
+void MockServer::send(const SessionPtr &session, const QJsonObject &message, bool delayed)
+{
+	auto data = QJsonDocument{message}.toJson(QJsonDocument::Compact);
+	if(session->framing == Framing::LengthPrefixed) {
+		QByteArray header{HeaderSize, Qt::Uninitialized};
+		qToUnaligned(static_cast<quint32>(data.size()), header.data());
+		data.prepend(header);
+	}
+
+	// equal delays keep the reply order
+	if(delayed && _replyDelay > 0) {
+		QTimer::singleShot(_replyDelay, this, [session, data]() {
+			session->write(data);
+		});
+	} else
+		session->write(data);
+}
+
+void MockServer::broadcast(const QString &action)
+{
+	QJsonObject message;
+	message[QStringLiteral("action")] = action;
+	for(const auto &session : qAsConst(_sessions)) {
+		if(!session->clientKey.isEmpty())
+			send(session, message, false);
+	}
+}
+
+QJsonObject MockServer::handleRequest(Session &session, const QJsonObject &request)
+{
+	++_requestCount;
+	const auto action = request[QStringLiteral("action")].toString();
+	const auto nonce = QByteArray::fromBase64(request[QStringLiteral("nonce")].toString().toUtf8());
+	if(nonce.size() != crypto_box_NONCEBYTES)
+		return errorReply(action, 4); // KeePassCannotDecryptMessage
+
+	// key exchange is the only unencrypted request
+	if(action == QStringLiteral("change-public-keys")) {
+		const auto clientKey = QByteArray::fromBase64(request[QStringLiteral("publicKey")].toString().toUtf8());
+		if(clientKey.size() != crypto_box_PUBLICKEYBYTES)
+			return errorReply(action, 9); // KeePassKeyChangeFailed
+		session.clientKey = clientKey;
+
+		QJsonObject reply;
+		reply[QStringLiteral("action")] = action;
+		reply[QStringLiteral("version")] = Version;
+		reply[QStringLiteral("publicKey")] = QString::fromUtf8(_publicKey.toBase64());
+		reply[QStringLiteral("nonce")] = QString::fromUtf8(incremented(nonce).toBase64());
+		reply[QStringLiteral("success")] = QStringLiteral("true");
+		return reply;
+	} else if(session.clientKey.isEmpty())
+		return errorReply(action, 3); // KeePassPublicKeyNotReceived
+
+	const auto plain = decrypt(QByteArray::fromBase64(request[QStringLiteral("message")].toString().toUtf8()),
+							   session.clientKey,
+							   nonce);
+	if(plain.isNull())
+		return errorReply(action, 4); // KeePassCannotDecryptMessage
+	QJsonParseError error;
+	const auto message = QJsonDocument::fromJson(plain, &error).object();
+	if(error.error != QJsonParseError::NoError)
+		return errorReply(action, 13); // KeePassEmptyMessageReceived
+
+	QJsonObject response;
+	const auto errorCode = handleAction(action, message, response);
+	if(errorCode != 0)
+		return errorReply(action, errorCode);
+
+	const auto replyNonce = incremented(nonce);
+	response[QStringLiteral("version")] = Version;
+	response[QStringLiteral("success")] = QStringLiteral("true");
+	response[QStringLiteral("nonce")] = QString::fromUtf8(replyNonce.toBase64());
+
+	QJsonObject reply;
+	reply[QStringLiteral("action")] = action;
+	reply[QStringLiteral("message")] = QString::fromUtf8(encrypt(QJsonDocument{response}.toJson(QJsonDocument::Compact),
+																 session.clientKey,
+																 replyNonce).toBase64());
+	reply[QStringLiteral("nonce")] = QString::fromUtf8(replyNonce.toBase64());
+	return reply;
+}
+
+int MockServer::handleAction(const QString &action, const QJsonObject &message, QJsonObject &response)
+{
+	const auto hash = QString::fromUtf8(_databaseHash.toHex());
+	if(action == QStringLiteral("generate-password")) {
+		QByteArray password{18, Qt::Uninitialized};
+		randombytes_buf(password.data(), static_cast<size_t>(password.size()));
+		QJsonObject entry;
+		entry[QStringLiteral("login")] = password.size() * 8;
+		entry[QStringLiteral("password")] = QString::fromUtf8(password.toBase64());
+		response[QStringLiteral("entries")] = QJsonArray{entry};
+		return 0;
+	}
+
+	// everything else needs an open database
+	if(_locked)
+		return 1; // KeePassDatabaseNotOpen
+
+	if(action == QStringLiteral("get-databasehash")) {
+		response[QStringLiteral("hash")] = hash;
+		return 0;
+	} else if(action == QStringLiteral("associate")) {
+		const auto id = QStringLiteral("mock-client-%1").arg(_associations.size() + 1);
+		_associations.insert(id, message[QStringLiteral("idKey")].toString().toUtf8());
+		response[QStringLiteral("hash")] = hash;
+		response[QStringLiteral("id")] = id;
+		return 0;
+	} else if(action == QStringLiteral("test-associate")) {
+		const auto id = message[QStringLiteral("id")].toString();
+		if(!isAssociated(id, message[QStringLiteral("key")].toString()))
+			return 8; // KeePassAssociationFailed
+		response[QStringLiteral("hash")] = hash;
+		response[QStringLiteral("id")] = id;
+		return 0;
+	} else if(action == QStringLiteral("get-logins")) {
+		auto associated = false;
+		for(const auto keyVal : message[QStringLiteral("keys")].toArray()) {
+			const auto key = keyVal.toObject();
+			if(isAssociated(key[QStringLiteral("id")].toString(), key[QStringLiteral("key")].toString())) {
+				associated = true;
+				break;
+			}
+		}
+		if(!associated)
+			return 8; // KeePassAssociationFailed
+
+		const auto url = message[QStringLiteral("url")].toString();
+		if(url.isEmpty())
+			return 14; // KeePassNoUrlProvided
+		const auto &entries = entriesFor(url);
+		if(entries.isEmpty())
+			return 15; // KeePassNoLoginsFound
+		response[QStringLiteral("hash")] = hash;
+		response[QStringLiteral("count")] = entries.size();
+		response[QStringLiteral("entries")] = entries;
+		return 0;
+	} else if(action == QStringLiteral("set-login")) {
+		if(!_associations.contains(message[QStringLiteral("id")].toString()))
+			return 8; // KeePassAssociationFailed
+		const auto url = message[QStringLiteral("url")].toString();
+		if(url.isEmpty())
+			return 14; // KeePassNoUrlProvided
+
+		auto &entries = entriesFor(url);
+		const auto uuid = message[QStringLiteral("uuid")].toString();
+		auto index = -1;
+		for(auto i = 0; !uuid.isEmpty() && i < entries.size(); ++i) {
+			if(entries[i].toObject()[QStringLiteral("uuid")].toString() == uuid) {
+				index = i;
+				break;
+			}
+		}
+
+		auto entry = index == -1 ? QJsonObject{} : entries[index].toObject();
+		if(index == -1) {
+			QByteArray newUuid{16, Qt::Uninitialized};
+			randombytes_buf(newUuid.data(), static_cast<size_t>(newUuid.size()));
+			entry[QStringLiteral("uuid")] = QString::fromUtf8(newUuid.toHex());
+			entry[QStringLiteral("name")] = QUrl{url}.host();
+			entry[QStringLiteral("stringFields")] = QJsonArray{};
+		}
+		entry[QStringLiteral("login")] = message[QStringLiteral("login")];
+		entry[QStringLiteral("password")] = message[QStringLiteral("password")];
+		if(index == -1)
+			entries.append(entry);
+		else
+			entries[index] = entry;
+		return 0;
+	} else if(action == QStringLiteral("lock-database")) {
+		setLocked(true);
+		return 0;
+	} else
+		return 12; // KeePassIncorrectAction
+}
+
+bool MockServer::isAssociated(const QString &id, const QString &key) const
+{
+	const auto it = _associations.constFind(id);
+	return it != _associations.constEnd() && *it == key.toUtf8();
+}
+
+QJsonArray &MockServer::entriesFor(const QString &url)
+{
+	const QUrl parsedUrl{url};
+	const auto host = parsedUrl.host().isEmpty() ? url : parsedUrl.host();
+	auto it = _entries.find(host);
+	if(it != _entries.end())
+		return *it;
+
+	// synthetic entries are created once per host and stay stable afterwards
+	QJsonArray entries;
+	for(auto i = 0; i < _entryCount; ++i) {
+		const auto seed = QStringLiteral("%1/%2").arg(host).arg(i).toUtf8();
+		QByteArray uuid{16, Qt::Uninitialized};
+		crypto_generichash(reinterpret_cast<unsigned char*>(uuid.data()), static_cast<size_t>(uuid.size()),
+						   reinterpret_cast<const unsigned char*>(seed.constData()), static_cast<unsigned long long>(seed.size()),
+						   nullptr, 0);
+
+		QJsonObject entry;
+		entry[QStringLiteral("uuid")] = QString::fromUtf8(uuid.toHex());
+		entry[QStringLiteral("name")] = QStringLiteral("%1 #%2").arg(host).arg(i);
+		entry[QStringLiteral("login")] = QStringLiteral("user%1").arg(i);
+		entry[QStringLiteral("password")] = QString::fromUtf8(uuid.toBase64());
+		entry[QStringLiteral("totp")] = QString{};
+		entry[QStringLiteral("stringFields")] = QJsonArray{};
+		entries.append(entry);
+	}
+	return *_entries.insert(host, entries);
+}
+
+QByteArray MockServer::encrypt(const QByteArray &plain, const QByteArray &publicKey, const QByteArray &nonce) const
+{
+	QByteArray cipher{static_cast<int>(plain.size() + crypto_box_MACBYTES), Qt::Uninitialized};
+	const auto ok = crypto_box_easy(reinterpret_cast<unsigned char*>(cipher.data()),
+									reinterpret_cast<const unsigned char*>(plain.constData()),
+									static_cast<unsigned long long>(plain.size()),
+									reinterpret_cast<const unsigned char*>(nonce.constData()),
+									reinterpret_cast<const unsigned char*>(publicKey.constData()),
+									reinterpret_cast<const unsigned char*>(_secretKey.constData()));
+	return ok == 0 ? cipher : QByteArray{};
+}
+
+QByteArray MockServer::decrypt(const QByteArray &cipher, const QByteArray &publicKey, const QByteArray &nonce) const
+{
+	if(cipher.size() < static_cast<int>(crypto_box_MACBYTES))
+		return {};
+	QByteArray plain{static_cast<int>(cipher.size() - crypto_box_MACBYTES), Qt::Uninitialized};
+	const auto ok = crypto_box_open_easy(reinterpret_cast<unsigned char*>(plain.data()),
+										 reinterpret_cast<const unsigned char*>(cipher.constData()),
+										 static_cast<unsigned long long>(cipher.size()),
+										 reinterpret_cast<const unsigned char*>(nonce.constData()),
+										 reinterpret_cast<const unsigned char*>(publicKey.constData()),
+										 reinterpret_cast<const unsigned char*>(_secretKey.constData()));
+	return ok == 0 ? plain : QByteArray{};
+}
+
+QByteArray MockServer::incremented(QByteArray nonce)
+{
+	sodium_increment(reinterpret_cast<unsigned char*>(nonce.data()), static_cast<size_t>(nonce.size()));
+	return nonce;
+}
+
+QJsonObject MockServer::errorReply(const QString &action, int errorCode)
+{
+	// like KeePassXC, errors are sent unencrypted and without nonce
+	QJsonObject reply;
+	reply[QStringLiteral("action")] = action;
+	reply[QStringLiteral("errorCode")] = QString::number(errorCode);
+	reply[QStringLiteral("error")] = QStringLiteral("Mock server error %1").arg(errorCode);
+	return reply;
+}
@@ -0,0 +1,105 @@
+#ifndef KPXCCLIENT_MOCKSERVER_H
+#define KPXCCLIENT_MOCKSERVER_H
+
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QHash>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSharedPointer>
+
+class QLocalServer;
+class QSocketNotifier;
+class QFile;
+
+namespace KPXCClient {
+
+class LoopbackServer;
+
+class MockServer : public QObject
+{
+	Q_OBJECT
+
+	Q_PROPERTY(int entryCount READ entryCount WRITE setEntryCount NOTIFY entryCountChanged)
+	Q_PROPERTY(int replyDelay READ replyDelay WRITE setReplyDelay NOTIFY replyDelayChanged)
+	Q_PROPERTY(bool locked READ isLocked WRITE setLocked NOTIFY lockedChanged)
+
+public:
+	static const QString Version;
+
+	explicit MockServer(QObject *parent = nullptr);
+	~MockServer() override;
+
+	int entryCount() const;
+	int replyDelay() const;
+	bool isLocked() const;
+	QByteArray databaseHash() const;
+	int requestCount() const;
+
+	bool listen(const QString &serverName);
+	void attach(LoopbackServer *server);
+	bool attachStdio();
+
+public Q_SLOTS:
+	void setEntryCount(int entryCount);
+	void setReplyDelay(int replyDelay);
+	void setLocked(bool locked);
+
+Q_SIGNALS:
+	void entryCountChanged(int entryCount);
+	void replyDelayChanged(int replyDelay);
+	void lockedChanged(bool locked);
+	void stdioClosed();
+
+private:
+	enum class Framing {
+		LengthPrefixed,
+		JsonStream,
+		Message
+	};
+
+	struct Session {
+		Framing framing;
+		std::function<void(const QByteArray &)> write;
+		QByteArray buffer;
+		QByteArray clientKey;
+	};
+	using SessionPtr = QSharedPointer<Session>;
+
+	QByteArray _publicKey;
+	QByteArray _secretKey;
+	QByteArray _databaseHash;
+	int _entryCount = 10;
+	int _replyDelay = 0;
+	bool _locked = false;
+	int _requestCount = 0;
+
+	QList<SessionPtr> _sessions;
+	QHash<QString, QByteArray> _associations;
+	QHash<QString, QJsonArray> _entries;
+
+	QLocalServer *_localServer = nullptr;
+	QSocketNotifier *_stdinNotifier = nullptr;
+	QFile *_stdout = nullptr;
+
+	SessionPtr createSession(Framing framing, std::function<void(const QByteArray &)> write);
+	void removeSession(const SessionPtr &session);
+	void receive(const SessionPtr &session, const QByteArray &data);
+	void send(const SessionPtr &session, const QJsonObject &message, bool delayed = true);
+	void broadcast(const QString &action);
+
+	QJsonObject handleRequest(Session &session, const QJsonObject &request);
+	int handleAction(const QString &action, const QJsonObject &message, QJsonObject &response);
+	bool isAssociated(const QString &id, const QString &key) const;
+	QJsonArray &entriesFor(const QString &url);
+
+	QByteArray encrypt(const QByteArray &plain, const QByteArray &publicKey, const QByteArray &nonce) const;
+	QByteArray decrypt(const QByteArray &cipher, const QByteArray &publicKey, const QByteArray &nonce) const;
+	static QByteArray incremented(QByteArray nonce);
+	static QJsonObject errorReply(const QString &action, int errorCode);
+};
+
+}
+
+#endif // KPXCCLIENT_MOCKSERVER_H
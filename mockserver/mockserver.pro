@@ -0,0 +1,6 @@
+TEMPLATE = subdirs
+
+SUBDIRS += lib \
+	app
+
+app.depends += lib
@@ -0,0 +1,88 @@
+#ifndef KPXCCLIENT_AWAITABLE_H
+#define KPXCCLIENT_AWAITABLE_H
+
+#include <QtCore/QFuture>
+#include <QtCore/QFutureWatcher>
+
+#include "kpxcclient_global.h"
+#include "clientexception.h"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define KPXCCLIENT_HAS_COROUTINES
+
+namespace KPXCClient {
+
+template <typename T>
+class FutureAwaiterBase
+{
+public:
+	explicit FutureAwaiterBase(QFuture<T> future) :
+		_future{std::move(future)}
+	{}
+
+	bool await_ready() const {
+		return _future.isFinished() || _future.isCanceled();
+	}
+
+	void await_suspend(std::coroutine_handle<> handle) {
+		// resumes on the suspending thread, once the future finished or was canceled
+		auto watcher = new QFutureWatcher<T>{};
+		const auto resume = [watcher, handle]() {
+			watcher->disconnect();
+			watcher->deleteLater();
+			handle.resume();
+		};
+		QObject::connect(watcher, &QFutureWatcherBase::finished,
+						 watcher, resume);
+		QObject::connect(watcher, &QFutureWatcherBase::canceled,
+						 watcher, resume);
+		watcher->setFuture(_future);
+	}
+
+protected:
+	QFuture<T> _future;
+
+	void throwIfFailed(bool hasResult) {
+		// rethrows a reported ClientException
+		if(_future.isFinished())
+			_future.waitForFinished();
+		if(_future.isCanceled() && !hasResult)
+			throw ClientException{Client::Error::ClientRequestCanceled, Client::tr("The request was canceled")};
+	}
+};
+
+template <typename T>
+class FutureAwaiter : public FutureAwaiterBase<T>
+{
+public:
+	using FutureAwaiterBase<T>::FutureAwaiterBase;
+
+	T await_resume() {
+		this->throwIfFailed(this->_future.resultCount() > 0);
+		return this->_future.result();
+	}
+};
+
+template <>
+class FutureAwaiter<void> : public FutureAwaiterBase<void>
+{
+public:
+	using FutureAwaiterBase<void>::FutureAwaiterBase;
+
+	void await_resume() {
+		throwIfFailed(false);
+	}
+};
+
+template <typename T>
+FutureAwaiter<T> awaitable(QFuture<T> future)
+{
+	return FutureAwaiter<T>{std::move(future)};
+}
+
+}
+
+#endif
+
+#endif // KPXCCLIENT_AWAITABLE_H
@@ -1,8 +1,16 @@
 #include "client.h"
 #include "client_p.h"
+#include "clientexception.h"
+#include "connectionpool.h"
+#include "connectionpool_p.h"
 #include "defaultdatabaseregistry.h"
+#include "noncewindow_p.h"
+#include "sockettransport_p.h"
 #include <QtCore/QDebug>
 #include <QtCore/QJsonArray>
+#include <QtCore/QSet>
+#include <algorithm>
+#include <array>
 #include <sodium/randombytes.h>
 #include <sodium/randombytes_sysrandom.h>
 #include <sodium/core.h>
@@ -35,20 +43,7 @@ Client::Client(QObject *parent) :
 	connect(this, &Client::databaseClosed,
 			this, &Client::stateChanged);
 
-	connect(d->connector, &Connector::connected,
-			this, &Client::dbConnected);
-	connect(d->connector, &Connector::disconnected,
-			this, &Client::dbDisconnected);
-	connect(d->connector, &Connector::error,
-			this, &Client::dbError);
-	connect(d->connector, &Connector::locked,
-			this, &Client::dbLocked);
-	connect(d->connector, &Connector::unlocked,
-			this, &Client::dbUnlocked);
-	connect(d->connector, &Connector::messageReceived,
-			this, &Client::dbMsgRecv);
-	connect(d->connector, &Connector::messageFailed,
-			this, &Client::dbMsgFail);
+	d->connectSignals(d->connector);
 }
 
 Client::~Client() = default;
@@ -63,11 +58,38 @@ Client::Options Client::options() const
 	return d->options;
 }
 
+qint64 Client::sendHighWaterMark() const
+{
+	return d->connectorThread ?
+				d->connectorThread->highWaterMark() :
+				d->connector->highWaterMark();
+}
+
+int Client::loginCacheTtl() const
+{
+	return static_cast<int>(d->loginCache.ttl().count());
+}
+
+int Client::loginCacheSize() const
+{
+	return d->loginCache.maxSize();
+}
+
+int Client::missCacheTtl() const
+{
+	return static_cast<int>(d->missCache.ttl().count());
+}
+
+Client::LoginStatistics Client::loginStatistics() const
+{
+	return d->loginStatistics;
+}
+
 Client::State Client::state() const
 {
-	if(d->connector->isConnected())
+	if(d->isConnected())
 		return d->locked ? State::Locked : State::Unlocked;
-	else if(d->connector->isConnecting())
+	else if(d->isConnecting())
 		return State::Connecting;
 	else
 		return State::Disconnected;
@@ -78,85 +100,150 @@ QByteArray Client::currentDatabase() const
 	return d->currentDatabase;
 }
 
+bool Client::isSendBufferFull() const
+{
+	return d->connectorThread ?
+				d->connectorThread->isSendBufferFull() :
+				d->connector->isSendBufferFull();
+}
+
+QFuture<QStringList> Client::generatePasswordAsync()
+{
+	return d->trackCall<QStringList>(generatePassword(), &ClientPrivate::readPasswords);
+}
+
+QFuture<QList<Entry>> Client::getLoginsAsync(const QUrl &url, const QUrl &submitUrl, bool httpAuth, bool searchAllDatabases)
+{
+	return d->trackCall<QList<Entry>>(getLogins(url, submitUrl, httpAuth, searchAllDatabases), &ClientPrivate::readEntries);
+}
+
+QFuture<Client::LoginResults> Client::getLoginsBatchAsync(const QList<QUrl> &urls, bool httpAuth, bool searchAllDatabases, int maxConcurrent)
+{
+	return d->startBatch(urls, httpAuth, searchAllDatabases, maxConcurrent);
+}
+
+QFuture<void> Client::addLoginAsync(const QUrl &url, const Entry &entry, const QUrl &submitUrl)
+{
+	return d->trackCall(addLogin(url, entry, submitUrl));
+}
+
 void Client::connectToKeePass(const QString &keePassPath)
 {
-	if(d->connector->isConnected()) {
+	if(d->isActive()) {
+		d->setError({}, Error::ClientAlreadyConnected);
+		return;
+	}
+
+	d->clear();
+	d->updateConnectorThread();
+	if(d->options.testFlag(Option::PreferDirectSocket))
+		d->connectToSocket(SocketTransport::defaultServerName(), keePassPath);
+	else if(d->connectorThread)
+		d->connectorThread->connectToKeePass(keePassPath);
+	else
+		d->connector->connectToKeePass(keePassPath);
+}
+
+void Client::connectToSocket(const QString &serverName)
+{
+	if(d->isActive()) {
+		d->setError({}, Error::ClientAlreadyConnected);
+		return;
+	}
+
+	d->clear();
+	d->updateConnectorThread();
+	d->connectToSocket(serverName.isEmpty() ? SocketTransport::defaultServerName() : serverName, {});
+}
+
+void Client::connectToLoopback(LoopbackServer *server)
+{
+	if(d->isActive()) {
 		d->setError({}, Error::ClientAlreadyConnected);
 		return;
 	}
 
 	d->clear();
-	d->connector->connectToKeePass(keePassPath);
+	d->updateConnectorThread();
+	d->connectToLoopback(server);
+}
+
+void Client::connectFromPool(ConnectionPool *pool)
+{
+	// the current connector is only replaced once it has no transport left
+	if(d->isActive()) {
+		d->setError({}, Error::ClientAlreadyConnected);
+		return;
+	}
+
+	const auto connector = pool->d->take();
+	if(!connector) {
+		connectToKeePass(pool->keePassPath());
+		return;
+	}
+
+	d->clear();
+	d->adoptConnector(connector);
+	// a pooled exchange that is still running reports through connected()
+	if(connector->isKeyExchanged())
+		QMetaObject::invokeMethod(this, &Client::dbConnected, Qt::QueuedConnection);
+	else if(!connector->isKeyExchangePending())
+		connector->exchangeKeys();
+	d->updateConnectorThread();
 }
 
 void Client::disconnectFromKeePass()
 {
-	d->connector->disconnectFromKeePass();
+	if(d->connectorThread)
+		d->connectorThread->disconnectFromKeePass();
+	else
+		d->connector->disconnectFromKeePass();
 }
 
 void Client::openDatabase()
 {
 	if(state() != State::Locked)
 		return;
-	d->connector->sendEncrypted(ClientPrivate::ActionGetDatabaseHash, {},
-								d->options.testFlag(Option::TriggerUnlock));
+	d->send(Protocol::GetDatabaseHashRequest{}, d->options.testFlag(Option::TriggerUnlock));
 }
 
 void Client::closeDatabase()
 {
 	if(state() != State::Unlocked)
 		return;
-	d->connector->sendEncrypted(ClientPrivate::ActionLockDatabase);
+	d->send(Protocol::LockDatabaseRequest{});
 }
 
-void Client::generatePassword()
+quint64 Client::generatePassword()
 {
-	d->connector->sendEncrypted(ClientPrivate::ActionGeneratePassword);
+	return d->send(Protocol::GeneratePasswordRequest{});
 }
 
-void Client::getLogins(const QUrl &url, const QUrl &submitUrl, bool httpAuth, bool searchAllDatabases)
+quint64 Client::getLogins(const QUrl &url, const QUrl &submitUrl, bool httpAuth, bool searchAllDatabases)
 {
-	QJsonObject message;
-	message[QStringLiteral("id")] = d->dbReg->getClientId(d->currentDatabase).name;
-	message[QStringLiteral("url")] = url.toString(QUrl::FullyEncoded);
-	if(!submitUrl.isEmpty())
-		message[QStringLiteral("submitUrl")] = submitUrl.toString(QUrl::FullyEncoded);
-	else
-		message[QStringLiteral("submitUrl")] = message[QStringLiteral("url")];
-	message[QStringLiteral("httpAuth")] = QVariant{httpAuth}.toString();
-
-	QList<IDatabaseRegistry::ClientId> clientIds;
-	if(searchAllDatabases)
-		clientIds = d->dbReg->getAllClientIds();
-	else
-		clientIds.append(d->dbReg->getClientId(d->currentDatabase));
-	QJsonArray keys;
-	for(const auto &cId : qAsConst(clientIds)) {
-		QJsonObject keyInfo;
-		keyInfo[QStringLiteral("id")] = cId.name;
-		keyInfo[QStringLiteral("key")] = cId.key.toBase64();
-		keys.append(keyInfo);
-	}
-	message[QStringLiteral("keys")] = keys;
-
-	d->connector->sendEncrypted(ClientPrivate::ActionGetLogins, message);
+	const auto requestId = d->reserveRequestId();
+	d->getLogins(requestId, d->loginsRequest(httpAuth, searchAllDatabases), url, submitUrl, searchAllDatabases);
+	return requestId;
 }
 
-void Client::addLogin(const QUrl &url, const Entry &entry, const QUrl &submitUrl)
+quint64 Client::addLogin(const QUrl &url, const Entry &entry, const QUrl &submitUrl)
 {
-	QJsonObject message;
-	message[QStringLiteral("id")] = d->dbReg->getClientId(d->currentDatabase).name;
-	message[QStringLiteral("url")] = url.toString(QUrl::FullyEncoded);
-	if(!submitUrl.isEmpty())
-		message[QStringLiteral("submitUrl")] = submitUrl.toString(QUrl::FullyEncoded);
-	else
-		message[QStringLiteral("submitUrl")] = message[QStringLiteral("url")];
+	// the new login may show up in any cached or coalesced lookup
+	d->loginCache.clear();
+	d->flightIds.clear();
+
+	Protocol::SetLoginRequest request;
+	request.id = d->dbReg->getClientId(d->currentDatabase).name;
+	request.url = url.toString(QUrl::FullyEncoded);
+	request.submitUrl = submitUrl.isEmpty() ? request.url : submitUrl.toString(QUrl::FullyEncoded);
 	if(entry.isStored())
-		message[QStringLiteral("uuid")] = entry.uuid().toString(QUuid::Id128);
-	message[QStringLiteral("login")] = entry.username();
-	message[QStringLiteral("password")] = entry.password();
+		request.uuid = entry.uuid().toString(QUuid::Id128);
+	request.login = entry.username();
+	request.password = entry.password();
 
-	d->connector->sendEncrypted(ClientPrivate::ActionSetLogin, message);
+	const auto requestId = d->send(request);
+	d->missCache.trackAdd(requestId, url.host());
+	return requestId;
 }
 
 void Client::setDatabaseRegistry(IDatabaseRegistry *databaseRegistry)
@@ -180,6 +267,50 @@ void Client::setOptions(Options options)
 	emit optionsChanged(d->options, {});
 }
 
+void Client::setLoginCacheTtl(int loginCacheTtl)
+{
+	if (this->loginCacheTtl() == loginCacheTtl)
+		return;
+
+	d->loginCache.setTtl(std::chrono::milliseconds{loginCacheTtl});
+	emit loginCacheTtlChanged(loginCacheTtl, {});
+}
+
+void Client::setLoginCacheSize(int loginCacheSize)
+{
+	if (this->loginCacheSize() == loginCacheSize)
+		return;
+
+	d->loginCache.setMaxSize(loginCacheSize);
+	emit loginCacheSizeChanged(loginCacheSize, {});
+}
+
+void Client::setMissCacheTtl(int missCacheTtl)
+{
+	if (this->missCacheTtl() == missCacheTtl)
+		return;
+
+	d->missCache.setTtl(std::chrono::milliseconds{missCacheTtl});
+	emit missCacheTtlChanged(missCacheTtl, {});
+}
+
+void Client::clearLoginCache()
+{
+	d->clearCaches();
+}
+
+void Client::setSendHighWaterMark(qint64 sendHighWaterMark)
+{
+	if (this->sendHighWaterMark() == sendHighWaterMark)
+		return;
+
+	if(d->connectorThread)
+		d->connectorThread->setHighWaterMark(sendHighWaterMark);
+	else
+		d->connector->setHighWaterMark(sendHighWaterMark);
+	emit sendHighWaterMarkChanged(sendHighWaterMark, {});
+}
+
 bool Client::allowDatabase(const QByteArray &databaseHash) const
 {
 	Q_UNUSED(databaseHash)
@@ -207,6 +338,7 @@ void Client::dbError(Client::Error code, const QString &message)
 
 void Client::dbLocked()
 {
+	d->clearCaches();
 	if(d->locked)
 		return;
 
@@ -218,56 +350,83 @@ void Client::dbLocked()
 
 void Client::dbUnlocked()
 {
+	d->clearCaches();
 	if(!d->locked)
 		return;
 
 	openDatabase();
 }
 
-void Client::dbMsgRecv(const QString &action, const QJsonObject &message)
-{
-	if(action == ClientPrivate::ActionGetDatabaseHash)
-		d->onDbHash(message);
-	else if(action == ClientPrivate::ActionAssociate)
-		d->onAssoc(message);
-	else if(action == ClientPrivate::ActionTestAssociate)
-		d->onTestAssoc(message);
-	else if(action == ClientPrivate::ActionGeneratePassword)
-		d->onGeneratePasswd(message);
-	else if(action == ClientPrivate::ActionGetLogins)
-		d->onGetLogins(message);
-	else if(action == ClientPrivate::ActionSetLogin)
-		emit loginAdded({});
-	else if(action == ClientPrivate::ActionLockDatabase)
-		dbLocked();
-	else
-		d->setError(action, Error::ClientUnsupportedAction, action);
+void Client::dbMsgRecv(quint64 requestId, const QString &action, const QJsonObject &message)
+{
+	// requests coalesced into this one share its reply
+	const auto followers = d->takeFlight(requestId);
+	d->loginCache.complete(requestId, message);
+	d->missCache.complete(requestId);
+	if(!d->resolveCall(requestId, message) &&
+	   !d->resolveBatch(requestId, message) &&
+	   !d->dispatchReply(requestId, Protocol::actionFromName(action), message))
+		d->setError(action, Error::ClientUnsupportedAction, action, requestId);
+	for(const auto follower : followers)
+		dbMsgRecv(follower, action, message);
 }
 
-void Client::dbMsgFail(const QString &action, Error code, const QString &message)
+void Client::dbMsgFail(quint64 requestId, const QString &action, Error code, const QString &message)
 {
+	// coalesced requests fail with it, but only this one disconnects on unrecoverable errors
+	const auto unrecoverable = ClientPrivate::isUnrecoverable(code);
+	const auto followers = d->takeFlight(requestId);
+	for(const auto follower : followers) {
+		if(unrecoverable)
+			d->failFollower(follower, action, code, message);
+		else
+			dbMsgFail(follower, action, code, message);
+	}
+
+	d->loginCache.drop(requestId);
+	d->missCache.fail(requestId, code == Error::KeePassNoLoginsFound, message);
+	if(d->rejectCall(requestId, action, code, message) ||
+	   d->rejectBatch(requestId, action, code, message)) {
+		// errors that break the connection are still reported for the whole client
+		if(unrecoverable)
+			d->setError(action, code, message, requestId);
+		return;
+	}
+
+	const auto actionId = Protocol::actionFromName(action);
 	if(code == Error::KeePassDatabaseNotOpen &&
-	   action == ClientPrivate::ActionGetDatabaseHash &&
+	   actionId == Protocol::Action::GetDatabaseHash &&
 	   d->options.testFlag(Option::TriggerUnlock)) {
 		qInfo() << "Database locked. Waiting for user to unlock";
 	} else if(code == Error::KeePassAssociationFailed &&
-			  action == ClientPrivate::ActionTestAssociate) {
+			  actionId == Protocol::Action::TestAssociate) {
 		qWarning() << "Current association was rejected. Initiation re-association";
 		d->dbReg->removeClientId(d->currentDatabase);
 		d->sendAssoc();
 	} else
-		d->setError(action, code, message);
+		d->setError(action, code, message, requestId);
 }
 
 // ------------- Private implementation -------------
 
-const QString ClientPrivate::ActionGetDatabaseHash{QStringLiteral("get-databasehash")};
-const QString ClientPrivate::ActionTestAssociate{QStringLiteral("test-associate")};
-const QString ClientPrivate::ActionAssociate{QStringLiteral("associate")};
-const QString ClientPrivate::ActionGeneratePassword{QStringLiteral("generate-password")};
-const QString ClientPrivate::ActionGetLogins{QStringLiteral("get-logins")};
-const QString ClientPrivate::ActionSetLogin{QStringLiteral("set-login")};
-const QString ClientPrivate::ActionLockDatabase{QStringLiteral("lock-database")};
+namespace {
+
+// replies are dispatched by action id. Actions without a handler are unsupported
+constexpr auto ReplyHandlers = []() {
+	using Protocol::Action;
+	using Protocol::actionIndex;
+	std::array<ClientPrivate::ReplyHandler, Protocol::ActionCount> handlers{};
+	handlers[actionIndex(Action::GetDatabaseHash)] = &ClientPrivate::handleReply<Protocol::DatabaseHashReply, &ClientPrivate::onDbHash>;
+	handlers[actionIndex(Action::Associate)] = &ClientPrivate::handleReply<Protocol::AssociateReply, &ClientPrivate::onAssoc>;
+	handlers[actionIndex(Action::TestAssociate)] = &ClientPrivate::handleReply<Protocol::AssociateReply, &ClientPrivate::onTestAssoc>;
+	handlers[actionIndex(Action::GeneratePassword)] = &ClientPrivate::onGeneratePasswd;
+	handlers[actionIndex(Action::GetLogins)] = &ClientPrivate::onGetLogins;
+	handlers[actionIndex(Action::SetLogin)] = &ClientPrivate::onSetLogin;
+	handlers[actionIndex(Action::LockDatabase)] = &ClientPrivate::onLockDatabase;
+	return handlers;
+}();
+
+}
 
 bool ClientPrivate::initialized = false;
 
@@ -277,9 +436,8 @@ ClientPrivate::ClientPrivate(Client *q_ptr) :
 	dbReg{new DefaultDatabaseRegistry{q_ptr}}
 {}
 
-void ClientPrivate::setError(const QString &action, Client::Error error, const QString &msg)
+QString ClientPrivate::errorString(Client::Error error, const QString &msg)
 {
-	QString errorMessage;
 	switch(error) {
 	// KeePassXC errors -> only use msg description
 	case Client::Error::KeePassDatabaseNotOpen:
@@ -297,44 +455,40 @@ void ClientPrivate::setError(const QString &action, Client::Error error, const Q
 	case Client::Error::KeePassEmptyMessageReceived:
 	case Client::Error::KeePassNoUrlProvided:
 	case Client::Error::KeePassNoLoginsFound:
-		errorMessage = msg;
-		break;
+		return msg;
 	// Client errors
 	case Client::Error::ClientAlreadyConnected:
-		errorMessage = Client::tr("Already connected to a KeePassXC instance");
-		break;
+		return Client::tr("Already connected to a KeePassXC instance");
 	case Client::Error::ClientKeyGenerationFailed:
-		errorMessage = Client::tr("Failed to generate session keys");
-		break;
+		return Client::tr("Failed to generate session keys");
 	case Client::Error::ClientReceivedNonceInvalid:
-		errorMessage = Client::tr("Unexpected nonce received from KeePassXC");
-		break;
+		return Client::tr("Unexpected nonce received from KeePassXC");
 	case Client::Error::ClientJsonParseError:
-		errorMessage = Client::tr("Received JSON-data is invalid. JSON-Error: %1")
-						  .arg(msg);
-		break;
+		return Client::tr("Received JSON-data is invalid. JSON-Error: %1")
+			   .arg(msg);
 	case Client::Error::ClientUnsupportedVersion:
-		errorMessage = Client::tr("Unsupported KeePassXC Version. Must be at least %1, but currently is %2")
-						  .arg(Connector::minimumKeePassXCVersion.toString(), msg);
-		break;
+		return Client::tr("Unsupported KeePassXC Version. Must be at least %1, but currently is %2")
+			   .arg(Connector::minimumKeePassXCVersion.toString(), msg);
 	case Client::Error::ClientDatabaseChanged:
-		errorMessage = Client::tr("The opened database in KeePassXC was changed");
-		break;
+		return Client::tr("The opened database in KeePassXC was changed");
 	case Client::Error::ClientDatabaseRejected:
-		errorMessage = Client::tr("The database hash was not known and thus rejected");
-		break;
+		return Client::tr("The database hash was not known and thus rejected");
+	case Client::Error::ClientRequestCanceled:
+		return Client::tr("The request was canceled");
+	case Client::Error::ClientSecureMemoryExhausted:
+		return Client::tr("Not enough secure memory left to send the request");
 	case Client::Error::ClientUnsupportedAction:
-		errorMessage = Client::tr("An unsupported action was received from KeePassXC: %1")
-						  .arg(msg);
-		break;
+		return Client::tr("An unsupported action was received from KeePassXC: %1")
+			   .arg(msg);
 	// General errors
 	case Client::Error::UnknownError:
 	default:
-		errorMessage = Client::tr("Unknown Error");
-		break;
+		return Client::tr("Unknown Error");
 	}
+}
 
-	auto unrecoverable = true;
+bool ClientPrivate::isUnrecoverable(Client::Error error)
+{
 	switch (error) {
 	// KeePassXC errors -> only use msg description
 	case Client::Error::KeePassDatabaseNotOpen:
@@ -348,13 +502,118 @@ void ClientPrivate::setError(const QString &action, Client::Error error, const Q
 	// Client errors
 	case Client::Error::ClientAlreadyConnected:
 	case Client::Error::ClientDatabaseChanged:
-		unrecoverable = false;
-		break;
+	case Client::Error::ClientRequestCanceled:
+	case Client::Error::ClientSecureMemoryExhausted:
+		return false;
 	default:
-		break;
+		return true;
+	}
+}
+
+void ClientPrivate::updateConnectorThread()
+{
+	// the connector can only switch threads while disconnected or freshly taken from a pool
+	const auto threaded = options.testFlag(Client::Option::ThreadedConnection);
+	if(threaded && !connectorThread) {
+		connector->disconnect(q);
+		connectorThread = new ConnectorThread{connector, q};
+		connectSignals(connectorThread);
+	} else if(!threaded && connectorThread) {
+		connectorThread->release();
+		delete connectorThread;
+		connectorThread = nullptr;
+		connector->setParent(q);
+		connectSignals(connector);
 	}
+	connector->cryptor()->setBufferedRandom(options.testFlag(Client::Option::BufferedRandom));
+}
 
-	emit q->errorOccured(error, errorMessage, action, unrecoverable, {});
+void ClientPrivate::adoptConnector(Connector *newConnector)
+{
+	if(connectorThread) {
+		connectorThread->release();
+		delete connectorThread;
+		connectorThread = nullptr;
+	}
+	Q_ASSERT(!connector->hasTransport());
+	connector->disconnect(q);
+	connector->deleteLater();
+
+	connector = newConnector;
+	connector->setParent(q);
+	connectSignals(connector);
+}
+
+bool ClientPrivate::isConnected() const
+{
+	return connectorThread ?
+				connectorThread->isConnected() :
+				connector->isConnected();
+}
+
+bool ClientPrivate::isConnecting() const
+{
+	return connectorThread ?
+				connectorThread->isConnecting() :
+				connector->isConnecting();
+}
+
+bool ClientPrivate::isActive() const
+{
+	// includes the disconnect phases, in which state() already reports Disconnected
+	return connectorThread ?
+				connectorThread->isActive() :
+				connector->hasTransport();
+}
+
+void ClientPrivate::connectToSocket(const QString &serverName, const QString &fallbackTarget)
+{
+	if(connectorThread)
+		connectorThread->connectToSocket(serverName, fallbackTarget);
+	else
+		connector->connectToSocket(serverName, fallbackTarget);
+}
+
+void ClientPrivate::connectToLoopback(LoopbackServer *server)
+{
+	if(connectorThread)
+		connectorThread->connectToLoopback(server);
+	else
+		connector->connectToLoopback(server);
+}
+
+quint64 ClientPrivate::sendEncrypted(const QString &action, QJsonObject message, bool triggerUnlock)
+{
+	return connectorThread ?
+				connectorThread->sendEncrypted(action, std::move(message), triggerUnlock) :
+				connector->sendEncrypted(action, std::move(message), triggerUnlock);
+}
+
+void ClientPrivate::sendRequest(quint64 requestId, const QString &action, QJsonObject message, bool triggerUnlock)
+{
+	if(connectorThread)
+		connectorThread->sendRequest(requestId, action, std::move(message), triggerUnlock);
+	else
+		connector->sendRequest(requestId, action, std::move(message), triggerUnlock);
+}
+
+SecureByteArray ClientPrivate::publicKey() const
+{
+	return connectorThread ?
+				connectorThread->publicKey() :
+				connector->cryptor()->publicKey();
+}
+
+quint64 ClientPrivate::reserveRequestId()
+{
+	// the counter is atomic, so this is safe even if the connector runs on its own thread
+	return connector->reserveRequestId();
+}
+
+void ClientPrivate::setError(const QString &action, Client::Error error, const QString &msg, quint64 requestId)
+{
+	const auto unrecoverable = isUnrecoverable(error);
+	emit q->errorOccured(error, errorString(error, msg), action, unrecoverable, requestId, {});
 	if(unrecoverable)
 		q->disconnectFromKeePass();
 }
@@ -363,11 +622,270 @@ void ClientPrivate::clear()
 {
 	locked = true;
 	currentDatabase.clear();
+	clearCaches();
+	flights.clear();
+	cancelCalls();
+}
+
+void ClientPrivate::clearCaches()
+{
+	loginCache.clear();
+	missCache.clear();
+	// lookups in flight still answer their followers, but no new ones
+	flightIds.clear();
+}
+
+QList<quint64> ClientPrivate::takeFlight(quint64 requestId)
+{
+	auto it = flights.find(requestId);
+	if(it == flights.end())
+		return {};
+
+	const auto flight = *it;
+	flights.erase(it);
+	const auto leader = flightIds.constFind(flight.key);
+	if(leader != flightIds.constEnd() && *leader == requestId)
+		flightIds.remove(flight.key);
+	return flight.followers;
+}
+
+void ClientPrivate::failFollower(quint64 requestId, const QString &action, Client::Error error, const QString &msg)
+{
+	// reported like its leader, which disconnects the client once for all of them
+	loginCache.drop(requestId);
+	missCache.fail(requestId, false, msg);
+	if(!rejectCall(requestId, action, error, msg))
+		rejectBatch(requestId, action, error, msg);
+	emit q->errorOccured(error, errorString(error, msg), action, true, requestId, {});
+}
+
+QFuture<void> ClientPrivate::trackCall(quint64 requestId)
+{
+	QFutureInterface<void> futureInterface;
+	futureInterface.reportStarted();
+	pendingCalls.insert(requestId, {futureInterface, {}});
+	return futureInterface.future();
+}
+
+bool ClientPrivate::resolveCall(quint64 requestId, const QJsonObject &message)
+{
+	auto it = pendingCalls.find(requestId);
+	if(it == pendingCalls.end())
+		return false;
+
+	auto call = *it;
+	pendingCalls.erase(it);
+	if(!call.future.isCanceled() && call.resolve)
+		call.resolve(message);
+	call.future.reportFinished();
+	return true;
+}
+
+bool ClientPrivate::rejectCall(quint64 requestId, const QString &action, Client::Error error, const QString &msg)
+{
+	auto it = pendingCalls.find(requestId);
+	if(it == pendingCalls.end())
+		return false;
+
+	auto call = *it;
+	pendingCalls.erase(it);
+	call.future.reportException(ClientException{error, errorString(error, msg), action});
+	call.future.reportFinished();
+	return true;
+}
+
+void ClientPrivate::cancelCalls()
+{
+	const auto calls = std::exchange(pendingCalls, {});
+	for(auto call : calls) {
+		call.future.reportCanceled();
+		call.future.reportFinished();
+	}
+
+	const auto requests = std::exchange(batchRequests, {});
+	for(const auto &request : requests) {
+		if(!request.batch->finished) {
+			request.batch->finished = true;
+			request.batch->future.reportCanceled();
+			request.batch->future.reportFinished();
+		}
+	}
+}
+
+Protocol::GetLoginsRequest ClientPrivate::loginsRequest(bool httpAuth, bool searchAllDatabases) const
+{
+	// everything but the urls, so batches can share the keys array
+	Protocol::GetLoginsRequest request;
+	request.id = dbReg->getClientId(currentDatabase).name;
+	request.httpAuth = httpAuth;
+
+	QList<IDatabaseRegistry::ClientId> clientIds;
+	if(searchAllDatabases)
+		clientIds = dbReg->getAllClientIds();
+	else
+		clientIds.append(dbReg->getClientId(currentDatabase));
+	for(const auto &cId : qAsConst(clientIds)) {
+		QJsonObject keyInfo;
+		keyInfo[QStringLiteral("id")] = cId.name;
+		keyInfo[QStringLiteral("key")] = cId.key.toBase64();
+		request.keys.append(keyInfo);
+	}
+	return request;
 }
 
-void ClientPrivate::onDbHash(const QJsonObject &message)
+void ClientPrivate::getLogins(quint64 requestId, Protocol::GetLoginsRequest request, const QUrl &url, const QUrl &submitUrl, bool searchAllDatabases)
 {
-	const auto dbHash = QByteArray::fromHex(message[QStringLiteral("hash")].toString().toUtf8());
+	request.url = url.toString(QUrl::FullyEncoded);
+	request.submitUrl = submitUrl.isEmpty() ? request.url : submitUrl.toString(QUrl::FullyEncoded);
+
+	++loginStatistics.lookups;
+
+	// cache hits are delivered like replies, but without a round trip to KeePassXC
+	const auto useCache = options.testFlag(Client::Option::CacheLogins);
+	const auto useMissCache = options.testFlag(Client::Option::CacheMissingLogins);
+	const auto coalesce = options.testFlag(Client::Option::CoalesceLogins);
+	LoginCache::Key cacheKey;
+	if(useCache || useMissCache || coalesce)
+		cacheKey = {request.url, request.submitUrl, request.httpAuth, searchAllDatabases, currentDatabase};
+	if(useCache) {
+		QJsonObject cached;
+		if(loginCache.lookup(cacheKey, cached)) {
+			++loginStatistics.cacheHits;
+			QMetaObject::invokeMethod(q, [this, requestId, cached]() {
+				q->dbMsgRecv(requestId, Protocol::actionName(Protocol::Action::GetLogins), cached);
+			}, Qt::QueuedConnection);
+			return;
+		}
+	}
+	if(useMissCache) {
+		QString missMessage;
+		if(missCache.lookup(url.host(), cacheKey, missMessage)) {
+			++loginStatistics.missCacheHits;
+			QMetaObject::invokeMethod(q, [this, requestId, missMessage]() {
+				q->dbMsgFail(requestId, Protocol::actionName(Protocol::Action::GetLogins), Client::Error::KeePassNoLoginsFound, missMessage);
+			}, Qt::QueuedConnection);
+			return;
+		}
+	}
+
+	// an identical lookup in flight answers this one as well
+	if(coalesce) {
+		const auto leader = flightIds.constFind(cacheKey);
+		if(leader != flightIds.constEnd()) {
+			flights[*leader].followers.append(requestId);
+			++loginStatistics.coalesced;
+			return;
+		}
+		flightIds.insert(cacheKey, requestId);
+		flights.insert(requestId, {cacheKey, {}});
+	}
+
+	// tracked before sending, as a failed send is reported right away
+	++loginStatistics.sent;
+	if(useMissCache)
+		missCache.track(requestId, url.host(), cacheKey);
+	if(useCache)
+		loginCache.track(requestId, std::move(cacheKey));
+	send(requestId, request);
+}
+
+QFuture<Client::LoginResults> ClientPrivate::startBatch(const QList<QUrl> &urls, bool httpAuth, bool searchAllDatabases, int maxConcurrent)
+{
+	auto batch = LoginBatchPtr::create();
+	batch->future.reportStarted();
+	batch->request = loginsRequest(httpAuth, searchAllDatabases);
+	batch->searchAllDatabases = searchAllDatabases;
+	// requests beyond the nonce window would only wait in the connector
+	static_assert(Client::MaxBatchConcurrency == NonceWindow::Capacity, "The batch limit must match the nonce window");
+	batch->maxConcurrent = qBound(1, maxConcurrent, Client::MaxBatchConcurrency);
+
+	// identical urls are only requested once
+	QSet<QUrl> seen;
+	batch->urls.reserve(urls.size());
+	for(const auto &url : urls) {
+		if(!seen.contains(url)) {
+			seen.insert(url);
+			batch->urls.append(url);
+		}
+	}
+	batch->results.reserve(batch->urls.size());
+
+	const auto future = batch->future.future();
+	fillBatch(batch);
+	return future;
+}
+
+void ClientPrivate::fillBatch(const LoginBatchPtr &batch)
+{
+	// sends can fail synchronously and land back here, so only the outermost call loops
+	if(batch->filling || batch->finished)
+		return;
+	batch->filling = true;
+	const auto canceled = batch->future.isCanceled();
+	while(!canceled &&
+		  batch->inFlight < batch->maxConcurrent &&
+		  batch->next < batch->urls.size()) {
+		const auto url = batch->urls[batch->next++];
+		const auto requestId = reserveRequestId();
+		batchRequests.insert(requestId, {batch, url});
+		++batch->inFlight;
+		getLogins(requestId, batch->request, url, {}, batch->searchAllDatabases);
+	}
+	batch->filling = false;
+
+	if(batch->inFlight == 0 &&
+	   (canceled || batch->next == batch->urls.size())) {
+		batch->finished = true;
+		if(!canceled)
+			batch->future.reportResult(batch->results);
+		batch->future.reportFinished();
+	}
+}
+
+bool ClientPrivate::resolveBatch(quint64 requestId, const QJsonObject &message)
+{
+	auto it = batchRequests.find(requestId);
+	if(it == batchRequests.end())
+		return false;
+
+	const auto request = *it;
+	batchRequests.erase(it);
+	--request.batch->inFlight;
+	request.batch->results.insert(request.url, {readEntries(message), false, Client::Error::UnknownError, {}});
+	fillBatch(request.batch);
+	return true;
+}
+
+bool ClientPrivate::rejectBatch(quint64 requestId, const QString &action, Client::Error error, const QString &msg)
+{
+	auto it = batchRequests.find(requestId);
+	if(it == batchRequests.end())
+		return false;
+
+	const auto request = *it;
+	batchRequests.erase(it);
+	--request.batch->inFlight;
+	request.batch->results.insert(request.url, {{}, true, error, errorString(error, msg)});
+	fillBatch(request.batch);
+	return true;
+}
+
+bool ClientPrivate::dispatchReply(quint64 requestId, Protocol::Action action, const QJsonObject &message)
+{
+	if(action == Protocol::Action::Unknown)
+		return false;
+	const auto handler = ReplyHandlers[Protocol::actionIndex(action)];
+	if(!handler)
+		return false;
+	(this->*handler)(requestId, message);
+	return true;
+}
+
+void ClientPrivate::onDbHash(const Protocol::DatabaseHashReply &reply)
+{
+	const auto dbHash = QByteArray::fromHex(reply.hash.toUtf8());
+	if(dbHash != currentDatabase)
+		clearCaches();
 	if(currentDatabase.isEmpty()) {
 		currentDatabase = dbHash;
 		emit q->currentDatabaseChanged(currentDatabase, {});
@@ -376,7 +894,7 @@ void ClientPrivate::onDbHash(const QJsonObject &message)
 			currentDatabase = dbHash;
 			emit q->currentDatabaseChanged(currentDatabase, {});
 		} else {
-			setError(ActionGetDatabaseHash, Client::Error::ClientDatabaseChanged);
+			setError(Protocol::actionName(Protocol::Action::GetDatabaseHash), Client::Error::ClientDatabaseChanged);
 			return;
 		}
 	}
@@ -386,19 +904,19 @@ void ClientPrivate::onDbHash(const QJsonObject &message)
 	else if(q->allowDatabase(currentDatabase))
 		sendAssoc();
 	else
-		setError(ActionGetDatabaseHash, Client::Error::ClientDatabaseRejected);
+		setError(Protocol::actionName(Protocol::Action::GetDatabaseHash), Client::Error::ClientDatabaseRejected);
 }
 
-void ClientPrivate::onAssoc(const QJsonObject &message)
+void ClientPrivate::onAssoc(const Protocol::AssociateReply &reply)
 {
-	const auto hash = QByteArray::fromHex(message[QStringLiteral("hash")].toString().toUtf8());
+	const auto hash = QByteArray::fromHex(reply.hash.toUtf8());
 	if(hash != currentDatabase) {
-		setError(ActionAssociate, Client::Error::ClientDatabaseChanged);
+		setError(Protocol::actionName(Protocol::Action::Associate), Client::Error::ClientDatabaseChanged);
 		return;
 	}
 
 	IDatabaseRegistry::ClientId cId;
-	cId.name = message[QStringLiteral("id")].toString();
+	cId.name = reply.id;
 	cId.key = std::move(_keyCache);
 	cId.key.makeReadonly();
 	dbReg->addClientId(currentDatabase, std::move(cId));
@@ -406,28 +924,51 @@ void ClientPrivate::onAssoc(const QJsonObject &message)
 	emit q->databaseOpened(currentDatabase, {});
 }
 
-void ClientPrivate::onTestAssoc(const QJsonObject &message)
+void ClientPrivate::onTestAssoc(const Protocol::AssociateReply &reply)
 {
-	const auto hash = QByteArray::fromHex(message[QStringLiteral("hash")].toString().toUtf8());
+	const auto hash = QByteArray::fromHex(reply.hash.toUtf8());
 	if(hash != currentDatabase) {
-		setError(ActionTestAssociate, Client::Error::ClientDatabaseChanged);
+		setError(Protocol::actionName(Protocol::Action::TestAssociate), Client::Error::ClientDatabaseChanged);
 		return;
 	}
 	locked = false;
 	emit q->databaseOpened(currentDatabase, {});
 }
 
-void ClientPrivate::onGeneratePasswd(const QJsonObject &message)
+void ClientPrivate::onGeneratePasswd(quint64 requestId, const QJsonObject &message)
+{
+	emit q->passwordsGenerated(readPasswords(message), requestId, {});
+}
+
+void ClientPrivate::onGetLogins(quint64 requestId, const QJsonObject &message)
+{
+	emit q->loginsReceived(readEntries(message), requestId, {});
+}
+
+void ClientPrivate::onSetLogin(quint64 requestId, const QJsonObject &message)
+{
+	Q_UNUSED(message)
+	emit q->loginAdded(requestId, {});
+}
+
+void ClientPrivate::onLockDatabase(quint64 requestId, const QJsonObject &message)
+{
+	Q_UNUSED(requestId)
+	Q_UNUSED(message)
+	q->dbLocked();
+}
+
+QStringList ClientPrivate::readPasswords(const QJsonObject &message)
 {
 	const auto entries = message[QStringLiteral("entries")].toArray();
 	QStringList passwords;
 	passwords.reserve(entries.size());
 	for(const auto entry : entries)
 		passwords.append(entry.toObject()[QStringLiteral("password")].toString());
-	emit q->passwordsGenerated(passwords, {});
+	return passwords;
 }
 
-void ClientPrivate::onGetLogins(const QJsonObject &message)
+QList<Entry> ClientPrivate::readEntries(const QJsonObject &message)
 {
 	const auto jEntries = message[QStringLiteral("entries")].toArray();
 	QList<Entry> entries;
@@ -458,24 +999,30 @@ void ClientPrivate::onGetLogins(const QJsonObject &message)
 		entry.setExtraFields(std::move(extraFields));
 		entries.append(entry);
 	}
-	emit q->loginsReceived(entries, {});
+	return entries;
 }
 
 void ClientPrivate::sendTestAssoc()
 {
-	auto cId = dbReg->getClientId(currentDatabase);
-	QJsonObject message;
-	message[QStringLiteral("id")] = cId.name;
-	message[QStringLiteral("key")] = cId.key.toBase64();
-	connector->sendEncrypted(ActionTestAssociate, message);
+	const auto cId = dbReg->getClientId(currentDatabase);
+	Protocol::TestAssociateRequest request;
+	request.id = cId.name;
+	request.key = cId.key.toBase64();
+	send(request);
 }
 
 void ClientPrivate::sendAssoc()
 {
-	_keyCache = connector->cryptor()->generateRandom(crypto_box_PUBLICKEYBYTES, SecureByteArray::State::Readonly);
-	QJsonObject message;
-	message[QStringLiteral("key")] = connector->cryptor()->publicKey().toBase64();
-	message[QStringLiteral("idKey")] = _keyCache.toBase64();
+	// the connector may live on another thread, so the long-lived id key comes straight from the system
+	if(!_keyCache.reallocate(crypto_box_PUBLICKEYBYTES)) {
+		setError(Protocol::actionName(Protocol::Action::Associate), Client::Error::ClientKeyGenerationFailed);
+		return;
+	}
+	randombytes_buf(_keyCache.data(), _keyCache.size());
+	_keyCache.makeReadonly();
+	Protocol::AssociateRequest request;
+	request.key = publicKey().toBase64();
+	request.idKey = _keyCache.toBase64();
 	_keyCache.makeNoaccess();
-	connector->sendEncrypted(ActionAssociate, message);
+	send(request);
 }
@@ -2,9 +2,11 @@
 #define KPXCCLIENT_CLIENT_H
 
 #include <QtCore/QScopedPointer>
+#include <QtCore/QHash>
 #include <QtCore/QObject>
 #include <QtCore/QJsonObject>
 #include <QtCore/QUrl>
+#include <QtCore/QFuture>
 
 #include "kpxcclient_global.h"
 #include "idatabaseregistry.h"
@@ -12,6 +14,9 @@
 
 namespace KPXCClient {
 
+class ConnectionPool;
+class LoopbackServer;
+
 class ClientPrivate;
 class KPXCCLIENT_EXPORT Client : public QObject
 {
@@ -19,9 +24,14 @@ class KPXCCLIENT_EXPORT Client : public QObject
 
 	Q_PROPERTY(KPXCClient::IDatabaseRegistry* databaseRegistry READ databaseRegistry WRITE setDatabaseRegistry NOTIFY databaseRegistryChanged)
 	Q_PROPERTY(Options options READ options WRITE setOptions NOTIFY optionsChanged)
+	Q_PROPERTY(qint64 sendHighWaterMark READ sendHighWaterMark WRITE setSendHighWaterMark NOTIFY sendHighWaterMarkChanged)
+	Q_PROPERTY(int loginCacheTtl READ loginCacheTtl WRITE setLoginCacheTtl NOTIFY loginCacheTtlChanged)
+	Q_PROPERTY(int loginCacheSize READ loginCacheSize WRITE setLoginCacheSize NOTIFY loginCacheSizeChanged)
+	Q_PROPERTY(int missCacheTtl READ missCacheTtl WRITE setMissCacheTtl NOTIFY missCacheTtlChanged)
 
 	Q_PROPERTY(State state READ state NOTIFY stateChanged)
 	Q_PROPERTY(QByteArray currentDatabase READ currentDatabase NOTIFY currentDatabaseChanged)
+	Q_PROPERTY(bool sendBufferFull READ isSendBufferFull NOTIFY sendBufferFullChanged)
 
 public:
 	enum class Option {
@@ -31,6 +41,12 @@ public:
 		OpenOnConnect = 0x04,
 		AllowDatabaseChange = 0x08,
 		DisconnectOnClose = 0x10,
+		ThreadedConnection = 0x20,
+		PreferDirectSocket = 0x40,
+		BufferedRandom = 0x80,
+		CacheLogins = 0x100,
+		CacheMissingLogins = 0x200,
+		CoalesceLogins = 0x400,
 
 		Default = (Option::AllowNewDatabase | Option::TriggerUnlock | Option::OpenOnConnect)
 	};
@@ -73,36 +89,85 @@ public:
 		ClientUnsupportedVersion = 0x00050000,
 		ClientDatabaseChanged = 0x00060000,
 		ClientDatabaseRejected = 0x00070000,
-		ClientUnsupportedAction = 0x00080000
+		ClientUnsupportedAction = 0x00080000,
+		ClientRequestCanceled = 0x00090000,
+		ClientSecureMemoryExhausted = 0x000A0000
 	};
 	Q_ENUM(Error)
 
+	struct LoginResult {
+		QList<Entry> entries;
+		bool failed = false;
+		Error error = Error::UnknownError;
+		QString errorString;
+	};
+	using LoginResults = QHash<QUrl, LoginResult>;
+
+	struct LoginStatistics {
+		quint64 lookups = 0;
+		quint64 sent = 0;
+		quint64 coalesced = 0;
+		quint64 cacheHits = 0;
+		quint64 missCacheHits = 0;
+	};
+
+	static constexpr int DefaultBatchConcurrency = 16;
+	// a connection cannot have more requests pending, larger values are clamped
+	static constexpr int MaxBatchConcurrency = 256;
+
 	explicit Client(QObject *parent = nullptr);
 	~Client() override;
 
 	IDatabaseRegistry* databaseRegistry() const;
 	Options options() const;
+	qint64 sendHighWaterMark() const;
+	int loginCacheTtl() const;
+	int loginCacheSize() const;
+	int missCacheTtl() const;
+	LoginStatistics loginStatistics() const;
 	State state() const;
 	QByteArray currentDatabase() const;
+	bool isSendBufferFull() const;
+
+	QFuture<QStringList> generatePasswordAsync();
+	QFuture<QList<Entry>> getLoginsAsync(const QUrl &url,
+										 const QUrl &submitUrl = {},
+										 bool httpAuth = false,
+										 bool searchAllDatabases = false);
+	QFuture<LoginResults> getLoginsBatchAsync(const QList<QUrl> &urls,
+											  bool httpAuth = false,
+											  bool searchAllDatabases = false,
+											  int maxConcurrent = DefaultBatchConcurrency);
+	QFuture<void> addLoginAsync(const QUrl &url,
+								const Entry &entry,
+								const QUrl &submitUrl = {});
 
 public Q_SLOTS:
 	void connectToKeePass(const QString &keePassPath = QStringLiteral("keepassxc-proxy"));
+	void connectToSocket(const QString &serverName = {});
+	void connectToLoopback(KPXCClient::LoopbackServer *server);
+	void connectFromPool(KPXCClient::ConnectionPool *pool);
 	void disconnectFromKeePass();
 
 	void openDatabase();
 	void closeDatabase();
 
-	void generatePassword();
-	void getLogins(const QUrl &url,
-				   const QUrl &submitUrl = {},
-				   bool httpAuth = false,
-				   bool searchAllDatabases = false);
-	void addLogin(const QUrl &url,
-				  const Entry &entry,
-				  const QUrl &submitUrl = {});
+	quint64 generatePassword();
+	quint64 getLogins(const QUrl &url,
+					  const QUrl &submitUrl = {},
+					  bool httpAuth = false,
+					  bool searchAllDatabases = false);
+	quint64 addLogin(const QUrl &url,
+					 const Entry &entry,
+					 const QUrl &submitUrl = {});
 
 	void setDatabaseRegistry(IDatabaseRegistry* databaseRegistry);
 	void setOptions(Options options);
+	void setSendHighWaterMark(qint64 sendHighWaterMark);
+	void setLoginCacheTtl(int loginCacheTtl);
+	void setLoginCacheSize(int loginCacheSize);
+	void setMissCacheTtl(int missCacheTtl);
+	void clearLoginCache();
 
 Q_SIGNALS:
 	void connected(QPrivateSignal);
@@ -111,15 +176,20 @@ Q_SIGNALS:
 	void databaseOpened(const QByteArray &dbHash, QPrivateSignal);
 	void databaseClosed(QPrivateSignal);
 
-	void passwordsGenerated(const QStringList &passwords, QPrivateSignal);
-	void loginsReceived(const QList<Entry> &entries, QPrivateSignal);
-	void loginAdded(QPrivateSignal);
+	void passwordsGenerated(const QStringList &passwords, quint64 requestId, QPrivateSignal);
+	void loginsReceived(const QList<Entry> &entries, quint64 requestId, QPrivateSignal);
+	void loginAdded(quint64 requestId, QPrivateSignal);
 
 	void databaseRegistryChanged(IDatabaseRegistry* databaseRegistry, QPrivateSignal);
 	void optionsChanged(Options options, QPrivateSignal);
+	void sendHighWaterMarkChanged(qint64 sendHighWaterMark, QPrivateSignal);
+	void loginCacheTtlChanged(int loginCacheTtl, QPrivateSignal);
+	void loginCacheSizeChanged(int loginCacheSize, QPrivateSignal);
+	void missCacheTtlChanged(int missCacheTtl, QPrivateSignal);
 	void stateChanged(QPrivateSignal);
 	void currentDatabaseChanged(QByteArray currentDatabase, QPrivateSignal);
-	void errorOccured(Error error, const QString &message, const QString &action, bool unrecoverable, QPrivateSignal);
+	void sendBufferFullChanged(bool sendBufferFull, QPrivateSignal);
+	void errorOccured(Error error, const QString &message, const QString &action, bool unrecoverable, quint64 requestId, QPrivateSignal);
 
 protected:
 	virtual bool allowDatabase(const QByteArray &databaseHash) const;
@@ -130,8 +200,8 @@ private Q_SLOTS:
 	void dbError(Error code, const QString &message);
 	void dbLocked();
 	void dbUnlocked();
-	void dbMsgRecv(const QString &action, const QJsonObject &message);
-	void dbMsgFail(const QString &action, Error code, const QString &message);
+	void dbMsgRecv(quint64 requestId, const QString &action, const QJsonObject &message);
+	void dbMsgFail(quint64 requestId, const QString &action, Error code, const QString &message);
 
 private:
 	friend class ClientPrivate;
@@ -1,26 +1,61 @@
 #ifndef KPXCCLIENT_CLIENT_P_H
 #define KPXCCLIENT_CLIENT_P_H
 
+#include <functional>
+
+#include <QtCore/QFutureInterface>
+#include <QtCore/QHash>
+#include <QtCore/QSharedPointer>
+
 #include "client.h"
+#include "clientexception.h"
 #include "connector_p.h"
+#include "connectorthread_p.h"
+#include "protocol_p.h"
+#include "logincache_p.h"
+#include "negativecache_p.h"
 
 namespace KPXCClient {
 
 class ClientPrivate
 {
 public:
-	static const QString ActionGetDatabaseHash;
-	static const QString ActionTestAssociate;
-	static const QString ActionAssociate;
-	static const QString ActionGeneratePassword;
-	static const QString ActionGetLogins;
-	static const QString ActionSetLogin;
-	static const QString ActionLockDatabase;
-
 	static bool initialized;
 
+	struct PendingCall {
+		QFutureInterfaceBase future;
+		std::function<void(const QJsonObject &)> resolve;
+	};
+
+	struct LoginBatch {
+		QFutureInterface<Client::LoginResults> future;
+		Protocol::GetLoginsRequest request;
+		bool searchAllDatabases = false;
+		QList<QUrl> urls;
+		int next = 0;
+		int inFlight = 0;
+		int maxConcurrent = 1;
+		bool filling = false;
+		bool finished = false;
+		Client::LoginResults results;
+	};
+	using LoginBatchPtr = QSharedPointer<LoginBatch>;
+
+	struct BatchRequest {
+		LoginBatchPtr batch;
+		QUrl url;
+	};
+
+	struct Flight {
+		LoginCache::Key key;
+		QList<quint64> followers;
+	};
+
+	using ReplyHandler = void (ClientPrivate::*)(quint64, const QJsonObject &);
+
 	Client * const q;
-	Connector * const connector;
+	Connector *connector;
+	ConnectorThread *connectorThread = nullptr;
 
 	IDatabaseRegistry *dbReg;
 	Client::Options options = Client::Option::Default;
@@ -29,24 +64,146 @@ public:
 	bool locked = true;
 
 	SecureByteArray _keyCache;
+	QHash<quint64, PendingCall> pendingCalls;
+	QHash<quint64, BatchRequest> batchRequests;
+	LoginCache loginCache;
+	NegativeCache missCache;
+	QHash<LoginCache::Key, quint64> flightIds;
+	QHash<quint64, Flight> flights;
+	Client::LoginStatistics loginStatistics;
 
 	ClientPrivate(Client *q_ptr);
 
+	static QString errorString(Client::Error error, const QString &msg);
+	static bool isUnrecoverable(Client::Error error);
+	static QList<Entry> readEntries(const QJsonObject &message);
+	static QStringList readPasswords(const QJsonObject &message);
+
+	template <typename TConnector>
+	void connectSignals(TConnector *source);
+	void updateConnectorThread();
+	void adoptConnector(Connector *newConnector);
+	bool isConnected() const;
+	bool isConnecting() const;
+	bool isActive() const;
+	void connectToSocket(const QString &serverName, const QString &fallbackTarget);
+	void connectToLoopback(LoopbackServer *server);
+	quint64 sendEncrypted(const QString &action,
+						  QJsonObject message = {},
+						  bool triggerUnlock = false);
+	void sendRequest(quint64 requestId,
+					 const QString &action,
+					 QJsonObject message = {},
+					 bool triggerUnlock = false);
+	template <typename TRequest>
+	quint64 send(const TRequest &request, bool triggerUnlock = false);
+	template <typename TRequest>
+	void send(quint64 requestId, const TRequest &request, bool triggerUnlock = false);
+	SecureByteArray publicKey() const;
+	quint64 reserveRequestId();
+
 	void setError(const QString &action,
 				  Client::Error error,
-				  const QString &msg = {});
+				  const QString &msg = {},
+				  quint64 requestId = 0);
 	void clear();
+	void clearCaches();
+	QList<quint64> takeFlight(quint64 requestId);
+	void failFollower(quint64 requestId, const QString &action, Client::Error error, const QString &msg);
+
+	template <typename T, typename TConverter>
+	QFuture<T> trackCall(quint64 requestId, TConverter &&converter);
+	QFuture<void> trackCall(quint64 requestId);
+	bool resolveCall(quint64 requestId, const QJsonObject &message);
+	bool rejectCall(quint64 requestId, const QString &action, Client::Error error, const QString &msg);
+	void cancelCalls();
 
-	void onDbHash(const QJsonObject &message);
-	void onAssoc(const QJsonObject &message);
-	void onTestAssoc(const QJsonObject &message);
-	void onGeneratePasswd(const QJsonObject &message);
-	void onGetLogins(const QJsonObject &message);
+	Protocol::GetLoginsRequest loginsRequest(bool httpAuth, bool searchAllDatabases) const;
+	void getLogins(quint64 requestId,
+				   Protocol::GetLoginsRequest request,
+				   const QUrl &url,
+				   const QUrl &submitUrl,
+				   bool searchAllDatabases);
+	QFuture<Client::LoginResults> startBatch(const QList<QUrl> &urls,
+											 bool httpAuth,
+											 bool searchAllDatabases,
+											 int maxConcurrent);
+	void fillBatch(const LoginBatchPtr &batch);
+	bool resolveBatch(quint64 requestId, const QJsonObject &message);
+	bool rejectBatch(quint64 requestId, const QString &action, Client::Error error, const QString &msg);
+
+	bool dispatchReply(quint64 requestId, Protocol::Action action, const QJsonObject &message);
+	template <typename TReply, void (ClientPrivate::*THandler)(const TReply &)>
+	void handleReply(quint64 requestId, const QJsonObject &message);
+
+	void onDbHash(const Protocol::DatabaseHashReply &reply);
+	void onAssoc(const Protocol::AssociateReply &reply);
+	void onTestAssoc(const Protocol::AssociateReply &reply);
+	void onGeneratePasswd(quint64 requestId, const QJsonObject &message);
+	void onGetLogins(quint64 requestId, const QJsonObject &message);
+	void onSetLogin(quint64 requestId, const QJsonObject &message);
+	void onLockDatabase(quint64 requestId, const QJsonObject &message);
 
 	void sendTestAssoc();
 	void sendAssoc();
 };
 
+template <typename TConnector>
+void ClientPrivate::connectSignals(TConnector *source)
+{
+	QObject::connect(source, &TConnector::connected,
+					 q, &Client::dbConnected);
+	QObject::connect(source, &TConnector::disconnected,
+					 q, &Client::dbDisconnected);
+	QObject::connect(source, &TConnector::error,
+					 q, &Client::dbError);
+	QObject::connect(source, &TConnector::locked,
+					 q, &Client::dbLocked);
+	QObject::connect(source, &TConnector::unlocked,
+					 q, &Client::dbUnlocked);
+	QObject::connect(source, &TConnector::messageReceived,
+					 q, &Client::dbMsgRecv);
+	QObject::connect(source, &TConnector::messageFailed,
+					 q, &Client::dbMsgFail);
+	QObject::connect(source, &TConnector::sendBufferFullChanged,
+					 q, [this](bool full) {
+		emit q->sendBufferFullChanged(full, {});
+	});
+}
+
+template <typename TRequest>
+quint64 ClientPrivate::send(const TRequest &request, bool triggerUnlock)
+{
+	return sendEncrypted(Protocol::actionName(TRequest::Id), Protocol::toJson(request), triggerUnlock);
+}
+
+template <typename TRequest>
+void ClientPrivate::send(quint64 requestId, const TRequest &request, bool triggerUnlock)
+{
+	sendRequest(requestId, Protocol::actionName(TRequest::Id), Protocol::toJson(request), triggerUnlock);
+}
+
+template <typename TReply, void (ClientPrivate::*THandler)(const TReply &)>
+void ClientPrivate::handleReply(quint64 requestId, const QJsonObject &message)
+{
+	Q_UNUSED(requestId)
+	(this->*THandler)(Protocol::fromJson<TReply>(message));
+}
+
+template <typename T, typename TConverter>
+QFuture<T> ClientPrivate::trackCall(quint64 requestId, TConverter &&converter)
+{
+	QFutureInterface<T> futureInterface;
+	futureInterface.reportStarted();
+	pendingCalls.insert(requestId, {
+		futureInterface,
+		[futureInterface, converter{std::forward<TConverter>(converter)}](const QJsonObject &message) mutable {
+			futureInterface.reportResult(converter(message));
+		}
+	});
+	return futureInterface.future();
+}
+
 }
 
 #endif // KPXCCLIENT_CLIENT_P_H
@@ -0,0 +1,39 @@
+#include "clientexception.h"
+using namespace KPXCClient;
+
+ClientException::ClientException(Client::Error error, QString message, QString action) :
+	_error{error},
+	_message{std::move(message)},
+	_action{std::move(action)},
+	_what{_message.toUtf8()}
+{}
+
+Client::Error ClientException::error() const
+{
+	return _error;
+}
+
+QString ClientException::message() const
+{
+	return _message;
+}
+
+QString ClientException::action() const
+{
+	return _action;
+}
+
+const char *ClientException::what() const noexcept
+{
+	return _what.constData();
+}
+
+void ClientException::raise() const
+{
+	throw *this;
+}
+
+ClientException *ClientException::clone() const
+{
+	return new ClientException{*this};
+}
@@ -0,0 +1,36 @@
+#ifndef KPXCCLIENT_CLIENTEXCEPTION_H
+#define KPXCCLIENT_CLIENTEXCEPTION_H
+
+#include <QtCore/QException>
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+
+#include "kpxcclient_global.h"
+#include "client.h"
+
+namespace KPXCClient {
+
+class KPXCCLIENT_EXPORT ClientException : public QException
+{
+public:
+	ClientException(Client::Error error, QString message, QString action = {});
+
+	Client::Error error() const;
+	QString message() const;
+	QString action() const;
+
+	const char *what() const noexcept override;
+
+	void raise() const override;
+	ClientException *clone() const override;
+
+private:
+	Client::Error _error;
+	QString _message;
+	QString _action;
+	QByteArray _what;
+};
+
+}
+
+#endif // KPXCCLIENT_CLIENTEXCEPTION_H
@@ -0,0 +1,177 @@
+#include "connectionpool.h"
+#include "connectionpool_p.h"
+#include <QtCore/QDebug>
+#include <chrono>
+using namespace KPXCClient;
+
+ConnectionPool::ConnectionPool(QObject *parent) :
+	QObject{parent},
+	d{new ConnectionPoolPrivate{this}}
+{
+	connect(d->retryTimer, &QTimer::timeout,
+			this, &ConnectionPool::refill);
+	d->scheduleRefill();
+}
+
+ConnectionPool::ConnectionPool(int size, QObject *parent) :
+	ConnectionPool{parent}
+{
+	d->size = size;
+}
+
+ConnectionPool::~ConnectionPool() = default;
+
+QString ConnectionPool::keePassPath() const
+{
+	return d->keePassPath;
+}
+
+int ConnectionPool::size() const
+{
+	return d->size;
+}
+
+bool ConnectionPool::exchangeKeys() const
+{
+	return d->exchangeKeys;
+}
+
+int ConnectionPool::readyCount() const
+{
+	auto count = 0;
+	for(const auto connector : qAsConst(d->connectors)) {
+		if(d->exchangeKeys ? connector->isKeyExchanged() : connector->isConnected())
+			++count;
+	}
+	return count;
+}
+
+void ConnectionPool::refill()
+{
+	d->retryTimer->stop();
+	while(d->connectors.size() < d->size) {
+		auto connector = new Connector{this};
+		connect(connector, &Connector::connected,
+				this, [this]() {
+			emit readyCountChanged(readyCount(), {});
+		});
+		connect(connector, &Connector::disconnected,
+				this, [this, connector]() {
+			d->drop(connector);
+		});
+		connect(connector, &Connector::error,
+				this, [this, connector](Client::Error code, const QString &message) {
+			qWarning() << "Dropping pooled connection after error:" << code << message;
+			connector->disconnectFromKeePass();
+		});
+		d->connectors.append(connector);
+		connector->connectToKeePass(d->keePassPath, d->exchangeKeys);
+	}
+}
+
+void ConnectionPool::clear()
+{
+	for(auto connector : qAsConst(d->connectors))
+		d->release(connector);
+	d->connectors.clear();
+	emit readyCountChanged(0, {});
+}
+
+void ConnectionPool::setKeePassPath(QString keePassPath)
+{
+	if (d->keePassPath == keePassPath)
+		return;
+
+	d->keePassPath = std::move(keePassPath);
+	emit keePassPathChanged(d->keePassPath, {});
+	clear();
+	d->scheduleRefill();
+}
+
+void ConnectionPool::setSize(int size)
+{
+	if (d->size == size)
+		return;
+
+	d->size = size;
+	emit sizeChanged(d->size, {});
+	while(d->connectors.size() > d->size)
+		d->release(d->connectors.takeLast());
+	emit readyCountChanged(readyCount(), {});
+	d->scheduleRefill();
+}
+
+void ConnectionPool::setExchangeKeys(bool exchangeKeys)
+{
+	if (d->exchangeKeys == exchangeKeys)
+		return;
+
+	d->exchangeKeys = exchangeKeys;
+	emit exchangeKeysChanged(d->exchangeKeys, {});
+	if(d->exchangeKeys) {
+		for(auto connector : qAsConst(d->connectors))
+			connector->exchangeKeys();
+	}
+}
+
+// ------------- Private implementation -------------
+
+const QString ConnectionPoolPrivate::DefaultKeePassPath{QStringLiteral("keepassxc-proxy")};
+
+ConnectionPoolPrivate::ConnectionPoolPrivate(ConnectionPool *q_ptr) :
+	q{q_ptr},
+	retryTimer{new QTimer{q_ptr}}
+{
+	using namespace std::chrono_literals;
+	retryTimer->setInterval(1s);
+	retryTimer->setSingleShot(true);
+	retryTimer->setTimerType(Qt::CoarseTimer);
+}
+
+Connector *ConnectionPoolPrivate::take()
+{
+	// prefer the connection that got furthest in the handshake
+	auto best = -1;
+	for(auto i = 0; i < connectors.size(); ++i) {
+		const auto connector = connectors[i];
+		if(connector->isKeyExchanged()) {
+			best = i;
+			break;
+		} else if(best == -1 && connector->isConnected())
+			best = i;
+	}
+	if(best == -1)
+		return nullptr;
+
+	auto connector = connectors.takeAt(best);
+	connector->disconnect(q);
+	emit q->readyCountChanged(q->readyCount(), {});
+	scheduleRefill();
+	return connector;
+}
+
+void ConnectionPoolPrivate::scheduleRefill()
+{
+	QMetaObject::invokeMethod(q, &ConnectionPool::refill, Qt::QueuedConnection);
+}
+
+void ConnectionPoolPrivate::drop(Connector *connector)
+{
+	// retry delayed, so a proxy that fails to start does not spawn in a loop
+	connector->disconnect(q);
+	connector->deleteLater();
+	connectors.removeOne(connector);
+	emit q->readyCountChanged(q->readyCount(), {});
+	retryTimer->start();
+}
+
+void ConnectionPoolPrivate::release(Connector *connector)
+{
+	// deleted once the proxy went through all disconnect phases
+	connector->disconnect(q);
+	QObject::connect(connector, &Connector::disconnected,
+					 connector, &Connector::deleteLater);
+	connector->disconnectFromKeePass();
+	if(!connector->hasTransport())
+		connector->deleteLater();
+}
@@ -0,0 +1,56 @@
+#ifndef KPXCCLIENT_CONNECTIONPOOL_H
+#define KPXCCLIENT_CONNECTIONPOOL_H
+
+#include <QtCore/QObject>
+#include <QtCore/QScopedPointer>
+
+#include "kpxcclient_global.h"
+
+namespace KPXCClient {
+
+class Client;
+class ClientPrivate;
+
+class ConnectionPoolPrivate;
+class KPXCCLIENT_EXPORT ConnectionPool : public QObject
+{
+	Q_OBJECT
+
+	Q_PROPERTY(QString keePassPath READ keePassPath WRITE setKeePassPath NOTIFY keePassPathChanged)
+	Q_PROPERTY(int size READ size WRITE setSize NOTIFY sizeChanged)
+	Q_PROPERTY(bool exchangeKeys READ exchangeKeys WRITE setExchangeKeys NOTIFY exchangeKeysChanged)
+	Q_PROPERTY(int readyCount READ readyCount NOTIFY readyCountChanged)
+
+public:
+	explicit ConnectionPool(QObject *parent = nullptr);
+	explicit ConnectionPool(int size, QObject *parent = nullptr);
+	~ConnectionPool() override;
+
+	QString keePassPath() const;
+	int size() const;
+	bool exchangeKeys() const;
+	int readyCount() const;
+
+public Q_SLOTS:
+	void refill();
+	void clear();
+
+	void setKeePassPath(QString keePassPath);
+	void setSize(int size);
+	void setExchangeKeys(bool exchangeKeys);
+
+Q_SIGNALS:
+	void keePassPathChanged(const QString &keePassPath, QPrivateSignal);
+	void sizeChanged(int size, QPrivateSignal);
+	void exchangeKeysChanged(bool exchangeKeys, QPrivateSignal);
+	void readyCountChanged(int readyCount, QPrivateSignal);
+
+private:
+	friend class KPXCClient::Client;
+	friend class KPXCClient::ClientPrivate;
+	QScopedPointer<ConnectionPoolPrivate> d;
+};
+
+}
+
+#endif // KPXCCLIENT_CONNECTIONPOOL_H
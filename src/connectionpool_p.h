@@ -0,0 +1,35 @@
+#ifndef KPXCCLIENT_CONNECTIONPOOL_P_H
+#define KPXCCLIENT_CONNECTIONPOOL_P_H
+
+#include "connectionpool.h"
+#include "connector_p.h"
+
+#include <QtCore/QList>
+#include <QtCore/QTimer>
+
+namespace KPXCClient {
+
+class ConnectionPoolPrivate
+{
+public:
+	static const QString DefaultKeePassPath;
+
+	ConnectionPool * const q;
+	QTimer * const retryTimer;
+
+	QString keePassPath = DefaultKeePassPath;
+	int size = 1;
+	bool exchangeKeys = false;
+	QList<Connector*> connectors;
+
+	ConnectionPoolPrivate(ConnectionPool *q_ptr);
+
+	Connector *take();
+	void scheduleRefill();
+	void drop(Connector *connector);
+	void release(Connector *connector);
+};
+
+}
+
+#endif // KPXCCLIENT_CONNECTIONPOOL_P_H
@@ -1,7 +1,16 @@
 #include "connector_p.h"
+#include "processtransport_p.h"
+#include "loopbacktransport_p.h"
+#include "sockettransport_p.h"
+#include "envelopeencoder_p.h"
+#include "jsonwriter_p.h"
+#include "protocol_p.h"
 #include <QtCore/QDebug>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QStandardPaths>
+#include <sodium/crypto_box.h>
+#include <sodium/utils.h>
+#include <cstring>
 #include <chrono>
 using namespace KPXCClient;
 
@@ -10,6 +19,7 @@ const QVersionNumber Connector::minimumKeePassXCVersion{2, 3, 0};
 Connector::Connector(QObject *parent) :
 	QObject{parent},
 	_cryptor{new SodiumCryptor{this}},
+	_expiryTimer{new QTimer{this}},
 	_disconnectTimer{new QTimer{this}}
 {
 	using namespace std::chrono_literals;
@@ -18,6 +28,11 @@ Connector::Connector(QObject *parent) :
 	_disconnectTimer->setTimerType(Qt::CoarseTimer);
 	connect(_disconnectTimer, &QTimer::timeout,
 			this, &Connector::disconnectFromKeePass);
+
+	_expiryTimer->setInterval(5s);
+	_expiryTimer->setTimerType(Qt::VeryCoarseTimer);
+	connect(_expiryTimer, &QTimer::timeout,
+			this, &Connector::expireRequests);
 }
 
 bool Connector::isConnected() const
@@ -30,70 +45,120 @@ bool Connector::isConnecting() const
 	return _connectPhase == PhaseConnecting;
 }
 
+bool Connector::isKeyExchanged() const
+{
+	return isConnected() && !_serverKey.isNull();
+}
+
+bool Connector::isKeyExchangePending() const
+{
+	return _keyExchangePending ||
+			(isConnecting() && _exchangeKeysOnStart);
+}
+
+bool Connector::hasTransport() const
+{
+	return _transport;
+}
+
 SodiumCryptor *Connector::cryptor() const
 {
 	return _cryptor;
 }
 
-void Connector::connectToKeePass(const QString &target)
+qint64 Connector::bytesPending() const
 {
-	if(_process) {
-		emit error(Client::Error::ClientAlreadyConnected);
+	return _sendQueue.bytesQueued() + (_transport ? _transport->bytesToWrite() : 0);
+}
+
+qint64 Connector::highWaterMark() const
+{
+	return _highWaterMark;
+}
+
+bool Connector::isSendBufferFull() const
+{
+	return _sendBufferFull;
+}
+
+void Connector::setHighWaterMark(qint64 highWaterMark)
+{
+	_highWaterMark = highWaterMark;
+	updateSendBufferState();
+}
+
+std::chrono::milliseconds Connector::requestTimeout() const
+{
+	return _requestTimeout;
+}
+
+void Connector::setRequestTimeout(std::chrono::milliseconds requestTimeout)
+{
+	_requestTimeout = requestTimeout;
+}
+
+void Connector::connectToKeePass(const QString &target, bool exchangeKeys)
+{
+	if(!prepareConnect(exchangeKeys))
 		return;
-	}
+	_fallbackTarget.clear();
+	openTransport(new ProcessTransport{target, this});
+}
 
-	if(!_cryptor->createKeys()){
-		emit error(Client::Error::ClientKeyGenerationFailed);
+void Connector::connectToSocket(const QString &serverName, const QString &fallbackTarget, bool exchangeKeys)
+{
+	if(!prepareConnect(exchangeKeys))
 		return;
-	}
-	_serverKey.deallocate();
-	_clientId = _cryptor->generateRandomNonce(SecureByteArray::State::Readonly);
+	_fallbackTarget = fallbackTarget;
+	openTransport(new SocketTransport{serverName, this});
+}
 
-	_process = new QProcess{this};
-	_process->setProgram(target);
-	connect(_process, &QProcess::started,
-			this, &Connector::started);
-	connect(_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-			this, &Connector::finished);
-	connect(_process, &QProcess::errorOccurred,
-			this, &Connector::procError);
-	connect(_process, &QProcess::readyReadStandardOutput,
-			this, &Connector::stdOutReady);
-	connect(_process, &QProcess::readyReadStandardError,
-			this, &Connector::stdErrReady);
+void Connector::connectToLoopback(LoopbackServer *server, bool exchangeKeys)
+{
+	connectToTransport(new LoopbackTransport{server}, exchangeKeys);
+}
 
-	_connectPhase = PhaseConnecting;
-	_process->start();
+void Connector::connectToTransport(Transport *transport, bool exchangeKeys)
+{
+	if(!prepareConnect(exchangeKeys)) {
+		transport->deleteLater();
+		return;
+	}
+	_fallbackTarget.clear();
+	transport->setParent(this);
+	openTransport(transport);
 }
 
 void Connector::disconnectFromKeePass()
 {
-	if(!_process)
+	if(!_transport)
 		return;
 
 	switch(_connectPhase) {
 	case PhaseConnected:
 		qDebug() << "Disconnect Phase: Sending EOF";
 		_connectPhase = PhaseEof;
-		_process->closeWriteChannel();
+		flushSendQueue();
+		_transport->closeWriteChannel();
 		_disconnectTimer->start();
 		break;
 	case PhaseConnecting:
 	case PhaseEof:
 		qDebug() << "Disconnect Phase: Sending SIGTERM";
 		_connectPhase = PhaseTerminate;
-		_process->terminate();
+		_transport->terminate();
 		_disconnectTimer->start();
 		break;
 	case PhaseTerminate:
 		qDebug() << "Disconnect Phase: Sending SIGKILL";
 		_connectPhase = PhaseKill;
-		_process->kill();
+		_transport->kill();
 		_disconnectTimer->start();
 		break;
 	case PhaseKill:
-		qDebug() << "Disconnect Phase: Dropping process";
+		qDebug() << "Disconnect Phase: Dropping connection";
 		cleanup();
+		emit disconnected();
 		break;
 	default:
 		Q_UNREACHABLE();
@@ -101,118 +166,226 @@ void Connector::disconnectFromKeePass()
 	}
 }
 
-void Connector::sendEncrypted(const QString &action, QJsonObject message, bool triggerUnlock)
+quint64 Connector::reserveRequestId()
+{
+	return ++_lastRequestId;
+}
+
+void Connector::sendRequest(quint64 requestId, const QString &action, QJsonObject message, bool triggerUnlock)
+{
+	// requests need the session key, which only exists between the key exchange and the disconnect
+	if(!_transport || !_cryptor->hasSharedKey()) {
+		emit messageFailed(requestId, action, Client::Error::ClientRequestCanceled, tr("Not connected to KeePassXC"));
+		return;
+	}
+
+	// backpressure: requests wait in order until a reply frees a slot of the nonce window
+	if(_pendingRequests.isFull() || !_heldRequests.isEmpty()) {
+		_heldRequests.enqueue({requestId, action, std::move(message), triggerUnlock});
+		return;
+	}
+	dispatchRequest(requestId, action, std::move(message), triggerUnlock);
+}
+
+void Connector::dispatchRequest(quint64 requestId, const QString &action, QJsonObject message, bool triggerUnlock)
 {
 	auto nonce = _cryptor->generateRandomNonce();
+	if(nonce.isNull()) {
+		emit messageFailed(requestId, action, Client::Error::ClientSecureMemoryExhausted);
+		return;
+	}
 	message[QStringLiteral("action")] = action;
 #ifdef KPXCCLIENT_MSG_DEBUG
 	qDebug() << "[[SEND PLAIN MESSAGE]]" << message;
 #endif
-	auto encData = _cryptor->encrypt(QJsonDocument{message}.toJson(QJsonDocument::Compact),
-									 _serverKey,
-									 nonce);
-
-	QJsonObject msgData;
-	msgData[QStringLiteral("action")] = action;
-	msgData[QStringLiteral("message")] = QString::fromUtf8(encData.toBase64());
-	msgData[QStringLiteral("nonce")] = nonce.toBase64();
-	msgData[QStringLiteral("clientID")] = _clientId.toBase64();
-	msgData[QStringLiteral("triggerUnlock")] = QVariant{triggerUnlock}.toString();
+	// the envelope is encrypted and encoded straight into the send queue
+	_plainBuffer.resize(0);
+	JsonWriter{_plainBuffer}.write(message);
+	if(!EnvelopeEncoder::encode(_sendQueue, _cryptor, action, _plainBuffer, nonce, _clientId, triggerUnlock)) {
+		emit messageFailed(requestId, action, Client::Error::KeePassCannotEncryptMessage);
+		return;
+	}
 
-	nonce.increment();
-	nonce.makeReadonly();
-	_allowedNonces.insert(nonce);
+	// the reply is encrypted with the incremented nonce and identifies the request
+	NonceWindow::Nonce replyNonce;
+	memcpy(replyNonce.data(), nonce.constData(), replyNonce.size());
+	sodium_increment(replyNonce.data(), replyNonce.size());
+	_pendingRequests.insert(replyNonce, {requestId, action}, NonceWindow::Clock::now() + _requestTimeout);
+	if(!_expiryTimer->isActive())
+		_expiryTimer->start();
 
-	sendMessage(msgData);
+	scheduleFlush();
 }
 
-void Connector::started()
+quint64 Connector::sendEncrypted(const QString &action, QJsonObject message, bool triggerUnlock)
 {
-	_connectPhase = PhaseConnected;
-	auto nonce = _cryptor->generateRandomNonce();
-	QJsonObject keysMessage;
-	keysMessage[QStringLiteral("action")] = QStringLiteral("change-public-keys");
-	keysMessage[QStringLiteral("publicKey")] = _cryptor->publicKey().toBase64();
-	keysMessage[QStringLiteral("nonce")] = nonce.toBase64();
-	keysMessage[QStringLiteral("clientID")] = _clientId.toBase64();
+	const auto requestId = reserveRequestId();
+	sendRequest(requestId, action, std::move(message), triggerUnlock);
+	return requestId;
+}
 
-	nonce.increment();
-	nonce.makeReadonly();
-	_allowedNonces.insert(nonce);
+void Connector::exchangeKeys()
+{
+	// deferred until the connection was established
+	if(_connectPhase == PhaseConnecting) {
+		_exchangeKeysOnStart = true;
+		return;
+	} else if(_connectPhase != PhaseConnected || _keyExchangePending)
+		return;
 
+	auto nonce = _cryptor->generateRandomNonce();
+	if(nonce.isNull()) {
+		emit error(Client::Error::ClientKeyGenerationFailed);
+		return;
+	}
+	Protocol::ChangePublicKeysRequest request;
+	request.publicKey = _cryptor->publicKey().toBase64();
+	request.nonce = nonce.toBase64();
+	request.clientID = _clientId.toBase64();
+	auto keysMessage = Protocol::toJson(request);
+	keysMessage[QStringLiteral("action")] = Protocol::actionName(request.Id);
+
+	_keyExchangePending = true;
 	sendMessage(keysMessage);
 }
 
-void Connector::finished(int exitCode, QProcess::ExitStatus exitStatus)
+void Connector::started()
+{
+	_connectPhase = PhaseConnected;
+	if(_exchangeKeysOnStart)
+		exchangeKeys();
+}
+
+void Connector::finished()
 {
-	qInfo() << "Connection closed with code:" << exitCode
-			<< "(Status:" << exitStatus << ")";
 	cleanup();
 	emit disconnected();
 }
 
-void Connector::procError(QProcess::ProcessError error)
+void Connector::transportFailed(const QString &errorString)
 {
-	qCritical() << error << _process->errorString();
+	// fall back to the proxy if the direct connection is not available
+	const auto fallbackTarget = _fallbackTarget;
+	const auto exchangeKeys = _exchangeKeysOnStart;
+	cleanup();
+	if(!fallbackTarget.isEmpty()) {
+		qInfo() << "Falling back to" << fallbackTarget << "after:" << errorString;
+		connectToKeePass(fallbackTarget, exchangeKeys);
+	} else
+		emit disconnected();
 }
 
-void Connector::stdOutReady()
+void Connector::readyRead()
 {
-	// read the message
-	const auto encMessage = readMessageData();
+	// handle all complete frames. Stop if a handler disconnected
+	const SecureByteArray::AccessEpoch epoch;
+	QByteArray frame;
+	while(_transport) {
+		switch(_transport->readFrame(frame)) {
+		case FrameDecoder::Result::Incomplete:
+			return;
+		case FrameDecoder::Result::Invalid:
+			// the stream cannot be resynchronized after a broken frame
+			emit error(Client::Error::ClientJsonParseError, tr("Received invalid message frame"));
+			if(isConnected())
+				disconnectFromKeePass();
+			return;
+		case FrameDecoder::Result::Frame:
+			break;
+		default:
+			Q_UNREACHABLE();
+			break;
+		}
+
 #ifdef KPXCCLIENT_MSG_DEBUG
-	qDebug() << "[[RECEIVE RAW MESSAGE]]" << encMessage;
+		qDebug() << "[[RECEIVE RAW MESSAGE]]" << frame;
 #endif
-	if(encMessage.isEmpty())
-		return;
+		EnvelopeDecoder::Envelope envelope;
+		if(EnvelopeDecoder::decode(frame, envelope))
+			handleMessage(envelope);
+		else
+			emit error(Client::Error::ClientJsonParseError, tr("Received invalid message envelope"));
+	}
+}
 
-	// verify message
-	const auto action = encMessage[QStringLiteral("action")].toString();
-	if(!performChecks(action, encMessage))
+void Connector::flushSendQueue()
+{
+	_flushScheduled = false;
+	if(!_transport || _sendQueue.isEmpty())
 		return;
+	_transport->write(_sendQueue);
+	updateSendBufferState();
+}
 
-	// handle special messages
-	if(action == QStringLiteral("change-public-keys")) {
-		handleChangePublicKeys(encMessage[QStringLiteral("publicKey")].toString());
-		return;
-	} else if(action == QStringLiteral("database-locked")) {
-		emit locked();
-		return;
-	} else if(action == QStringLiteral("database-unlocked")) {
-		emit unlocked();
-		return;
+void Connector::updateSendBufferState()
+{
+	// drain to half of the high water mark before reporting free space again
+	const auto pending = bytesPending();
+	const auto full = _sendBufferFull ?
+						  pending > _highWaterMark / 2 :
+						  pending > _highWaterMark;
+	if(full != _sendBufferFull) {
+		_sendBufferFull = full;
+		emit sendBufferFullChanged(_sendBufferFull);
 	}
+}
 
-	//verify nonce
-	const auto kpNonce = SecureByteArray::fromBase64(encMessage[QStringLiteral("nonce")].toString(), SecureByteArray::State::Readonly);
-	if(!_allowedNonces.remove(kpNonce)) {
-		emit messageFailed(action, Client::Error::ClientReceivedNonceInvalid);
-		return;
+bool Connector::prepareConnect(bool exchangeKeys)
+{
+	if(_transport) {
+		emit error(Client::Error::ClientAlreadyConnected);
+		return false;
 	}
 
-	// decrypt message
-	const auto plainData = _cryptor->decrypt(QByteArray::fromBase64(encMessage[QStringLiteral("message")].toString().toUtf8()),
-											 _serverKey,
-											 kpNonce);
-	QJsonParseError error;
-	const auto message = QJsonDocument::fromJson(plainData, &error).object();
-	if(error.error != QJsonParseError::NoError){
-		emit messageFailed(action, Client::Error::ClientJsonParseError, error.errorString());
-		return;
+	if(!_cryptor->createKeys()){
+		emit error(Client::Error::ClientKeyGenerationFailed);
+		return false;
 	}
-#ifdef KPXCCLIENT_MSG_DEBUG
-	qDebug() << "[[RECEIVE PLAIN MESSAGE]]" << message;
-#endif
+	_serverKey.deallocate();
+	_clientId = _cryptor->generateRandomNonce(SecureByteArray::State::Readonly);
+	if(_clientId.isNull()) {
+		emit error(Client::Error::ClientKeyGenerationFailed);
+		return false;
+	}
+	_exchangeKeysOnStart = exchangeKeys;
+	return true;
+}
 
-	// check for success
-	if(!performChecks(action, message))
-		return;
-	emit messageReceived(action, message);
+void Connector::openTransport(Transport *transport)
+{
+	_transport = transport;
+	_sendQueue.setLengthPrefixed(_transport->isLengthPrefixed());
+	connect(_transport, &Transport::started,
+			this, &Connector::started);
+	connect(_transport, &Transport::finished,
+			this, &Connector::finished);
+	connect(_transport, &Transport::failed,
+			this, &Connector::transportFailed);
+	connect(_transport, &Transport::readyRead,
+			this, &Connector::readyRead);
+	connect(_transport, &Transport::bytesWritten,
+			this, &Connector::updateSendBufferState);
+
+	_connectPhase = PhaseConnecting;
+	_transport->open();
 }
 
-void Connector::stdErrReady()
+void Connector::expireRequests()
 {
-	qWarning() << "stderr" << _process->readAllStandardError();
+	_pendingRequests.expire(NonceWindow::Clock::now(), [this](const NonceWindow::Request &request) {
+		emit messageFailed(request.id, request.action, Client::Error::KeePassTimeout, tr("No reply received"));
+	});
+	releaseHeldRequests();
+	if(_pendingRequests.isEmpty())
+		_expiryTimer->stop();
+}
+
+void Connector::releaseHeldRequests()
+{
+	while(!_heldRequests.isEmpty() && !_pendingRequests.isFull()) {
+		auto held = _heldRequests.dequeue();
+		dispatchRequest(held.requestId, held.action, std::move(held.message), held.triggerUnlock);
+	}
 }
 
 void Connector::sendMessage(const QJsonObject &message)
@@ -220,83 +393,182 @@ void Connector::sendMessage(const QJsonObject &message)
 #ifdef KPXCCLIENT_MSG_DEBUG
 	qDebug() << "[[SEND RAW MESSAGE]]" << message;
 #endif
-	const auto data = QJsonDocument{message}.toJson(QJsonDocument::Compact);
-	QByteArray length{sizeof(quint32), 0};
-	*reinterpret_cast<quint32*>(length.data()) = data.size();
-	_process->write(length + data);
+	_sendQueue.enqueue(JsonWriter::toJson(message));
+	scheduleFlush();
+}
+
+void Connector::scheduleFlush()
+{
+	// write all frames queued during this event loop iteration at once
+	if(!_flushScheduled) {
+		_flushScheduled = true;
+		QMetaObject::invokeMethod(this, &Connector::flushSendQueue, Qt::QueuedConnection);
+	}
+	updateSendBufferState();
 }
 
 void Connector::cleanup()
 {
 	_disconnectTimer->stop();
-	if(_process) {
-		_process->disconnect(this);
-		_process->deleteLater();
-		_process = nullptr;
+	_expiryTimer->stop();
+	if(_transport) {
+		_transport->disconnect(this);
+		_transport->deleteLater();
+		_transport = nullptr;
 	}
+	_fallbackTarget.clear();
 	_cryptor->dropKeys();
 	_serverKey.deallocate();
 	_clientId.deallocate();
-	_allowedNonces.clear();
+	_keyExchangePending = false;
+	_pendingRequests.clear();
+	_heldRequests.clear();
+	_sendQueue.clear();
+	_receiveBuffers.clear();
+	_plainBuffer = QByteArray{};
+	_versionText = QByteArray{};
+	_version = QVersionNumber{};
+	updateSendBufferState();
 	_connectPhase = PhaseKill;
 }
 
-QJsonObject Connector::readMessageData()
+void Connector::handleMessage(const EnvelopeDecoder::Envelope &envelope)
 {
-	// read the data
-	const auto sizeData = _process->peek(sizeof(quint32));
-	if(sizeData.size() != sizeof(quint32))
-		return {};
+	// known actions share their name, only unknown ones are converted
+	const auto actionId = Protocol::actionFromName(envelope.action);
+	const auto action = actionId == Protocol::Action::Unknown ?
+							QString::fromUtf8(envelope.action) :
+							Protocol::actionName(actionId);
 
-	const auto size = *reinterpret_cast<const quint32*>(sizeData.constData());
-	if(_process->bytesAvailable() < static_cast<qint64>(size + sizeof(quint32)))
-		return {};
+	// handle special messages
+	switch(actionId) {
+	case Protocol::Action::ChangePublicKeys:
+		_keyExchangePending = false;
+		if(performChecks(0, action, envelope))
+			handleChangePublicKeys(envelope.publicKey);
+		return;
+	case Protocol::Action::DatabaseLocked:
+		if(performChecks(0, action, envelope))
+			emit locked();
+		return;
+	case Protocol::Action::DatabaseUnlocked:
+		if(performChecks(0, action, envelope))
+			emit unlocked();
+		return;
+	default:
+		break;
+	}
 
-	_process->skip(sizeof(quint32));
-	const auto data = _process->read(size);
-	Q_ASSERT(data.size() == static_cast<int>(size));
+	// find the request via the nonce. Error replies come without one, but KeePassXC answers in order
+	NonceWindow::Nonce kpNonce;
+	NonceWindow::Request request;
+	const auto hasNonce = _receiveBuffers.decodeBase64(envelope.nonce, kpNonce.data(), kpNonce.size());
+	if(hasNonce)
+		request = _pendingRequests.take(kpNonce);
+	if(request.id == 0 && !envelope.isSuccess())
+		request = _pendingRequests.takeOldest(action);
+	if(request.id != 0)
+		releaseHeldRequests();
+	else if(hasNonce && _pendingRequests.takeTombstone(kpNonce)) {
+		// the request already timed out and was reported, so its late reply is not an error
+		qDebug() << "Dropping late reply for" << action;
+		return;
+	}
+
+	// verify message
+	if(!performChecks(request.id, action, envelope))
+		return;
+	if(request.id == 0) {
+		emit messageFailed(0, action, Client::Error::ClientReceivedNonceInvalid);
+		return;
+	}
 
-	// parse json
+	// decrypt message into the reused, secure plaintext buffer
+	const auto cipher = _receiveBuffers.decodeBase64(envelope.message);
+	if(cipher.size() < static_cast<int>(crypto_box_MACBYTES)) {
+		emit messageFailed(request.id, action, Client::Error::KeePassCannotDecryptMessage);
+		return;
+	}
+	const auto plainSize = static_cast<size_t>(cipher.size()) - crypto_box_MACBYTES;
+	const auto plain = _receiveBuffers.plaintext(plainSize);
+	if(!plain) {
+		emit messageFailed(request.id, action, Client::Error::ClientSecureMemoryExhausted);
+		return;
+	}
+
+	QJsonObject message;
 	QJsonParseError error;
-	const auto message = QJsonDocument::fromJson(data, &error).object();
-	if(error.error != QJsonParseError::NoError) {
-		emit this->error(Client::Error::ClientJsonParseError, error.errorString());
-		return {};
-	} else
-		return message;
+	{
+		SecureByteArray::StateLocker plainLocker{plain, SecureByteArray::State::Readwrite};
+		const auto decrypted = _cryptor->decryptInto(plain->data(),
+													 reinterpret_cast<const quint8*>(cipher.constData()),
+													 static_cast<size_t>(cipher.size()),
+													 kpNonce.data());
+		if(decrypted) {
+			message = QJsonDocument::fromJson(QByteArray::fromRawData(reinterpret_cast<const char*>(plain->constData()),
+																	  static_cast<int>(plainSize)),
+											  &error).object();
+		}
+		_receiveBuffers.wipe(plainSize);
+		if(!decrypted) {
+			emit messageFailed(request.id, action, Client::Error::KeePassCannotDecryptMessage);
+			return;
+		}
+	}
+	_receiveBuffers.trim();
+	if(error.error != QJsonParseError::NoError){
+		emit messageFailed(request.id, action, Client::Error::ClientJsonParseError, error.errorString());
+		return;
+	}
+#ifdef KPXCCLIENT_MSG_DEBUG
+	qDebug() << "[[RECEIVE PLAIN MESSAGE]]" << message;
+#endif
+
+	// check for success
+	if(!performChecks(request.id, action, EnvelopeDecoder::fromObject(message)))
+		return;
+	emit messageReceived(request.id, action, message);
 }
 
-bool Connector::performChecks(const QString &action, const QJsonObject &message)
+bool Connector::performChecks(quint64 requestId, const QString &action, const EnvelopeDecoder::Envelope &envelope)
 {
-	// verify version
-	if(message.contains(QStringLiteral("version"))) {
-		const auto kpVersion = QVersionNumber::fromString(message[QStringLiteral("version")].toString());
-		if(kpVersion < minimumKeePassXCVersion) {
-			messageFailed(action, Client::Error::ClientUnsupportedVersion, kpVersion.toString());
+	// verify version, which is only parsed again if it changed
+	if(!envelope.version.isNull()) {
+		if(envelope.version != _versionText) {
+			_versionText = QByteArray{envelope.version.constData(), envelope.version.size()};
+			_version = QVersionNumber::fromString(QString::fromUtf8(_versionText));
+		}
+		if(_version < minimumKeePassXCVersion) {
+			messageFailed(requestId, action, Client::Error::ClientUnsupportedVersion, _version.toString());
 			return false;
 		}
 	}
 
 	// read success status and cancel early if error
-	auto success = false;
-	if(message.contains(QStringLiteral("success")))
-		success = message[QStringLiteral("success")].toVariant().toBool();
-	else {
-		success = !message.contains(QStringLiteral("errorCode")) &&
-				  !message.contains(QStringLiteral("error"));
-	}
-	if(!success) {
-		emit messageFailed(action,
-						   static_cast<Client::Error>(message[QStringLiteral("errorCode")].toVariant().toInt()),
-						   message[QStringLiteral("error")].toString());
+	if(!envelope.isSuccess()) {
+		emit messageFailed(requestId,
+						   action,
+						   static_cast<Client::Error>(envelope.errorCode),
+						   QString::fromUtf8(envelope.error));
 		return false;
 	}
 
 	return true;
 }
 
-void Connector::handleChangePublicKeys(const QString &publicKey)
+void Connector::handleChangePublicKeys(const QByteArray &publicKey)
 {
-	_serverKey = SecureByteArray::fromBase64(publicKey, SecureByteArray::State::Readonly);
+	// decoded straight into secure memory
+	if(!_serverKey.reallocate(crypto_box_PUBLICKEYBYTES, SecureByteArray::State::Readwrite)) {
+		emit error(Client::Error::ClientSecureMemoryExhausted);
+		return;
+	}
+	if(!_receiveBuffers.decodeBase64(publicKey, _serverKey.data(), _serverKey.size()) ||
+	   !_serverKey.setState(SecureByteArray::State::Readonly) ||
+	   !_cryptor->precompute(_serverKey)) {
+		_serverKey.deallocate();
+		emit error(Client::Error::KeePassKeyChangeFailed);
+		return;
+	}
 	emit connected();
 }
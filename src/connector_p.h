@@ -2,15 +2,23 @@
 #define KPXCCLIENT_CONNECTOR_P_H
 
 #include <QtCore/QObject>
-#include <QtCore/QProcess>
 #include <QtCore/QJsonObject>
+#include <QtCore/QQueue>
 #include <QtCore/QTimer>
 #include <QtCore/QVersionNumber>
-#include <QtCore/QSet>
+
+#include <atomic>
+#include <chrono>
 
 #include "securebytearray.h"
 #include "client.h"
 #include "sodiumcryptor_p.h"
+#include "framequeue_p.h"
+#include "receivebuffers_p.h"
+#include "envelopedecoder_p.h"
+#include "noncewindow_p.h"
+#include "transport_p.h"
+#include "loopbackserver.h"
 
 namespace KPXCClient {
 
@@ -20,21 +28,44 @@ class Connector : public QObject
 
 public:
 	static const QVersionNumber minimumKeePassXCVersion;
+	static constexpr qint64 DefaultHighWaterMark = 1024 * 1024;
+	static constexpr std::chrono::milliseconds DefaultRequestTimeout = std::chrono::minutes{5};
 
 	explicit Connector(QObject *parent = nullptr);
 
 	bool isConnected() const;
 	bool isConnecting() const;
+	bool isKeyExchanged() const;
+	bool isKeyExchangePending() const;
+	bool hasTransport() const;
 
 	SodiumCryptor *cryptor() const;
+	quint64 reserveRequestId();
+	void sendRequest(quint64 requestId,
+					 const QString &action,
+					 QJsonObject message = {},
+					 bool triggerUnlock = false);
+
+	qint64 bytesPending() const;
+	qint64 highWaterMark() const;
+	bool isSendBufferFull() const;
+	void setHighWaterMark(qint64 highWaterMark);
+	std::chrono::milliseconds requestTimeout() const;
+	void setRequestTimeout(std::chrono::milliseconds requestTimeout);
 
 public Q_SLOTS:
-	void connectToKeePass(const QString &target);
+	void connectToKeePass(const QString &target, bool exchangeKeys = true);
+	void connectToSocket(const QString &serverName,
+						 const QString &fallbackTarget = {},
+						 bool exchangeKeys = true);
+	void connectToLoopback(KPXCClient::LoopbackServer *server, bool exchangeKeys = true);
+	void connectToTransport(KPXCClient::Transport *transport, bool exchangeKeys = true);
 	void disconnectFromKeePass();
+	void exchangeKeys();
 
-	void sendEncrypted(const QString &action,
-					   QJsonObject message = {},
-					   bool triggerUnlock = false);
+	quint64 sendEncrypted(const QString &action,
+						  QJsonObject message = {},
+						  bool triggerUnlock = false);
 
 Q_SIGNALS:
 	void connected();
@@ -43,23 +74,48 @@ Q_SIGNALS:
 
 	void locked();
 	void unlocked();
-	void messageReceived(const QString &action, const QJsonObject &message);
-	void messageFailed(const QString &action, Client::Error code, const QString &message ={});
+	void messageReceived(quint64 requestId, const QString &action, const QJsonObject &message);
+	void messageFailed(quint64 requestId, const QString &action, Client::Error code, const QString &message ={});
+	void sendBufferFullChanged(bool full);
 
 private Q_SLOTS:
 	void started();
-	void finished(int exitCode, QProcess::ExitStatus exitStatus);
-	void procError(QProcess::ProcessError error);
-	void stdOutReady();
-	void stdErrReady();
+	void finished();
+	void transportFailed(const QString &errorString);
+	void readyRead();
+	void flushSendQueue();
+	void updateSendBufferState();
+	void expireRequests();
 
 private:
-	QProcess *_process = nullptr;
+	Transport *_transport = nullptr;
+	QString _fallbackTarget;
 
 	SodiumCryptor *_cryptor;
 	SecureByteArray _serverKey;
 	SecureByteArray _clientId;
-	QSet<SecureByteArray> _allowedNonces;
+	bool _exchangeKeysOnStart = true;
+	bool _keyExchangePending = false;
+	struct HeldRequest {
+		quint64 requestId;
+		QString action;
+		QJsonObject message;
+		bool triggerUnlock;
+	};
+
+	NonceWindow _pendingRequests;
+	QQueue<HeldRequest> _heldRequests;
+	std::chrono::milliseconds _requestTimeout = DefaultRequestTimeout;
+	QTimer *_expiryTimer;
+	std::atomic<quint64> _lastRequestId{0};
+	FrameQueue _sendQueue;
+	ReceiveBuffers _receiveBuffers;
+	QByteArray _plainBuffer;
+	QByteArray _versionText;
+	QVersionNumber _version;
+	qint64 _highWaterMark = DefaultHighWaterMark;
+	bool _flushScheduled = false;
+	bool _sendBufferFull = false;
 
 	enum {
 		PhaseConnecting,
@@ -70,12 +126,17 @@ private:
 	} _connectPhase = PhaseKill;
 	QTimer *_disconnectTimer;
 
+	bool prepareConnect(bool exchangeKeys);
+	void openTransport(Transport *transport);
 	void sendMessage(const QJsonObject &message);
+	void dispatchRequest(quint64 requestId, const QString &action, QJsonObject message, bool triggerUnlock);
+	void releaseHeldRequests();
+	void scheduleFlush();
 	void cleanup();
 
-	QJsonObject readMessageData();
-	bool performChecks(const QString &action, const QJsonObject &message);
-	void handleChangePublicKeys(const QString &publicKey);
+	void handleMessage(const EnvelopeDecoder::Envelope &envelope);
+	bool performChecks(quint64 requestId, const QString &action, const EnvelopeDecoder::Envelope &envelope);
+	void handleChangePublicKeys(const QByteArray &publicKey);
 };
 
 }
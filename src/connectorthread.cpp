@@ -0,0 +1,312 @@
+#include "connectorthread_p.h"
+using namespace KPXCClient;
+
+ConnectorThread::ConnectorThread(Connector *connector, QObject *parent) :
+	QObject{parent},
+	_thread{new QThread{this}},
+	_connector{connector},
+	_connected{connector->isConnected()},
+	_connecting{connector->isConnecting()},
+	_active{connector->hasTransport()},
+	_sendBufferFull{connector->isSendBufferFull()},
+	_highWaterMark{connector->highWaterMark()},
+	_publicKey{connector->cryptor()->publicKey()},
+	_publishedConnected{_connected},
+	_publishedConnecting{_connecting},
+	_publishedActive{_active}
+{
+	_thread->setObjectName(QStringLiteral("KPXCClient::ConnectorThread"));
+
+	// connector signals are emitted on the connector thread and only queue events
+	connect(_connector, &Connector::connected,
+			this, [this]() {
+		Event event;
+		event.type = Event::Connected;
+		event.publicKey = _connector->cryptor()->publicKey();
+		postEvent(std::move(event));
+	}, Qt::DirectConnection);
+	connect(_connector, &Connector::disconnected,
+			this, [this]() {
+		Event event;
+		event.type = Event::Disconnected;
+		postEvent(std::move(event));
+	}, Qt::DirectConnection);
+	connect(_connector, &Connector::error,
+			this, [this](Client::Error code, const QString &message) {
+		Event event;
+		event.type = Event::Error;
+		event.error = code;
+		event.errorString = message;
+		postEvent(std::move(event));
+	}, Qt::DirectConnection);
+	connect(_connector, &Connector::locked,
+			this, [this]() {
+		Event event;
+		event.type = Event::Locked;
+		postEvent(std::move(event));
+	}, Qt::DirectConnection);
+	connect(_connector, &Connector::unlocked,
+			this, [this]() {
+		Event event;
+		event.type = Event::Unlocked;
+		postEvent(std::move(event));
+	}, Qt::DirectConnection);
+	connect(_connector, &Connector::messageReceived,
+			this, [this](quint64 requestId, const QString &action, const QJsonObject &message) {
+		Event event;
+		event.type = Event::MessageReceived;
+		event.requestId = requestId;
+		event.action = action;
+		event.message = message;
+		postEvent(std::move(event));
+	}, Qt::DirectConnection);
+	connect(_connector, &Connector::messageFailed,
+			this, [this](quint64 requestId, const QString &action, Client::Error code, const QString &message) {
+		Event event;
+		event.type = Event::MessageFailed;
+		event.requestId = requestId;
+		event.action = action;
+		event.error = code;
+		event.errorString = message;
+		postEvent(std::move(event));
+	}, Qt::DirectConnection);
+	connect(_connector, &Connector::sendBufferFullChanged,
+			this, [this](bool full) {
+		Event event;
+		event.type = Event::SendBufferFullChanged;
+		event.sendBufferFull = full;
+		postEvent(std::move(event));
+	}, Qt::DirectConnection);
+
+	_connector->setParent(nullptr);
+	_connector->moveToThread(_thread);
+	_deleteConnection = connect(_thread, &QThread::finished,
+								_connector, &QObject::deleteLater);
+	_thread->start();
+}
+
+ConnectorThread::~ConnectorThread()
+{
+	_thread->quit();
+	_thread->wait();
+}
+
+Connector *ConnectorThread::release()
+{
+	// hand the connector back to the calling thread, then stop the connector thread
+	const auto connector = _connector;
+	const auto targetThread = QThread::currentThread();
+	QMetaObject::invokeMethod(connector, [connector, targetThread]() {
+		connector->moveToThread(targetThread);
+	}, Qt::BlockingQueuedConnection);
+	connector->disconnect(this);
+	disconnect(_deleteConnection);
+	_thread->quit();
+	_thread->wait();
+	return connector;
+}
+
+bool ConnectorThread::isConnected() const
+{
+	return _connected;
+}
+
+bool ConnectorThread::isConnecting() const
+{
+	return _connecting;
+}
+
+bool ConnectorThread::isActive() const
+{
+	return _active;
+}
+
+SecureByteArray ConnectorThread::publicKey() const
+{
+	return _publicKey;
+}
+
+qint64 ConnectorThread::highWaterMark() const
+{
+	return _highWaterMark;
+}
+
+bool ConnectorThread::isSendBufferFull() const
+{
+	return _sendBufferFull;
+}
+
+void ConnectorThread::setHighWaterMark(qint64 highWaterMark)
+{
+	_highWaterMark = highWaterMark;
+	Command command;
+	command.type = Command::SetHighWaterMark;
+	command.highWaterMark = highWaterMark;
+	postCommand(std::move(command));
+}
+
+void ConnectorThread::connectToKeePass(const QString &target)
+{
+	_connecting = true;
+	_active = true;
+	Command command;
+	command.type = Command::Connect;
+	command.action = target;
+	postCommand(std::move(command));
+}
+
+void ConnectorThread::connectToSocket(const QString &serverName, const QString &fallbackTarget)
+{
+	_connecting = true;
+	_active = true;
+	Command command;
+	command.type = Command::ConnectSocket;
+	command.action = serverName;
+	command.fallbackTarget = fallbackTarget;
+	postCommand(std::move(command));
+}
+
+void ConnectorThread::connectToLoopback(LoopbackServer *server)
+{
+	_connecting = true;
+	_active = true;
+	Command command;
+	command.type = Command::ConnectLoopback;
+	command.loopbackServer = server;
+	postCommand(std::move(command));
+}
+
+void ConnectorThread::disconnectFromKeePass()
+{
+	Command command;
+	command.type = Command::Disconnect;
+	postCommand(std::move(command));
+}
+
+quint64 ConnectorThread::sendEncrypted(const QString &action, QJsonObject message, bool triggerUnlock)
+{
+	const auto requestId = _connector->reserveRequestId();
+	sendRequest(requestId, action, std::move(message), triggerUnlock);
+	return requestId;
+}
+
+void ConnectorThread::sendRequest(quint64 requestId, const QString &action, QJsonObject message, bool triggerUnlock)
+{
+	Command command;
+	command.type = Command::Send;
+	command.requestId = requestId;
+	command.action = action;
+	command.message = std::move(message);
+	command.triggerUnlock = triggerUnlock;
+	postCommand(std::move(command));
+}
+
+void ConnectorThread::postCommand(Command &&command)
+{
+	_commands.enqueue(std::move(command));
+	if(!_commandsScheduled.exchange(true)) {
+		QMetaObject::invokeMethod(_connector, [this]() {
+			processCommands();
+		}, Qt::QueuedConnection);
+	}
+}
+
+void ConnectorThread::processCommands()
+{
+	_commandsScheduled = false;
+	// keys opened for the first request of a batch stay open for the rest of it
+	const SecureByteArray::AccessEpoch epoch;
+	Command command;
+	while(_commands.dequeue(command)) {
+		switch(command.type) {
+		case Command::Connect:
+			_connector->connectToKeePass(command.action);
+			break;
+		case Command::ConnectSocket:
+			_connector->connectToSocket(command.action, command.fallbackTarget);
+			break;
+		case Command::ConnectLoopback:
+			_connector->connectToLoopback(command.loopbackServer);
+			break;
+		case Command::Disconnect:
+			_connector->disconnectFromKeePass();
+			break;
+		case Command::Send:
+			_connector->sendRequest(command.requestId,
+									command.action,
+									std::move(command.message),
+									command.triggerUnlock);
+			break;
+		case Command::SetHighWaterMark:
+			_connector->setHighWaterMark(command.highWaterMark);
+			break;
+		default:
+			Q_UNREACHABLE();
+			break;
+		}
+	}
+
+	// publish the connection state if the commands changed it without emitting a signal
+	if(_connector->isConnected() != _publishedConnected ||
+	   _connector->isConnecting() != _publishedConnecting ||
+	   _connector->hasTransport() != _publishedActive)
+		postEvent({});
+}
+
+void ConnectorThread::postEvent(Event &&event)
+{
+	event.connected = _publishedConnected = _connector->isConnected();
+	event.connecting = _publishedConnecting = _connector->isConnecting();
+	event.active = _publishedActive = _connector->hasTransport();
+	_events.enqueue(std::move(event));
+	if(!_eventsScheduled.exchange(true)) {
+		QMetaObject::invokeMethod(this, [this]() {
+			processEvents();
+		}, Qt::QueuedConnection);
+	}
+}
+
+void ConnectorThread::processEvents()
+{
+	_eventsScheduled = false;
+	Event event;
+	while(_events.dequeue(event)) {
+		_connected = event.connected;
+		_connecting = event.connecting;
+		_active = event.active;
+		switch(event.type) {
+		case Event::StateChanged:
+			break;
+		case Event::Connected:
+			_publicKey = std::move(event.publicKey);
+			emit connected();
+			break;
+		case Event::Disconnected:
+			_publicKey = {};
+			emit disconnected();
+			break;
+		case Event::Error:
+			emit error(event.error, event.errorString);
+			break;
+		case Event::Locked:
+			emit locked();
+			break;
+		case Event::Unlocked:
+			emit unlocked();
+			break;
+		case Event::MessageReceived:
+			emit messageReceived(event.requestId, event.action, event.message);
+			break;
+		case Event::MessageFailed:
+			emit messageFailed(event.requestId, event.action, event.error, event.errorString);
+			break;
+		case Event::SendBufferFullChanged:
+			_sendBufferFull = event.sendBufferFull;
+			emit sendBufferFullChanged(_sendBufferFull);
+			break;
+		default:
+			Q_UNREACHABLE();
+			break;
+		}
+	}
+}
@@ -0,0 +1,132 @@
+#ifndef KPXCCLIENT_CONNECTORTHREAD_P_H
+#define KPXCCLIENT_CONNECTORTHREAD_P_H
+
+#include <atomic>
+
+#include <QtCore/QObject>
+#include <QtCore/QThread>
+#include <QtCore/QJsonObject>
+#include <QtCore/QPointer>
+
+#include "securebytearray.h"
+#include "client.h"
+#include "connector_p.h"
+#include "spscqueue_p.h"
+
+namespace KPXCClient {
+
+class ConnectorThread : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit ConnectorThread(Connector *connector, QObject *parent = nullptr);
+	~ConnectorThread() override;
+
+	Connector *release();
+
+	bool isConnected() const;
+	bool isConnecting() const;
+	bool isActive() const;
+	SecureByteArray publicKey() const;
+
+	qint64 highWaterMark() const;
+	bool isSendBufferFull() const;
+	void setHighWaterMark(qint64 highWaterMark);
+
+	void connectToKeePass(const QString &target);
+	void connectToSocket(const QString &serverName, const QString &fallbackTarget);
+	void connectToLoopback(LoopbackServer *server);
+	void disconnectFromKeePass();
+	quint64 sendEncrypted(const QString &action,
+						  QJsonObject message = {},
+						  bool triggerUnlock = false);
+	void sendRequest(quint64 requestId,
+					 const QString &action,
+					 QJsonObject message = {},
+					 bool triggerUnlock = false);
+
+Q_SIGNALS:
+	void connected();
+	void disconnected();
+	void error(Client::Error code, const QString &message = {});
+
+	void locked();
+	void unlocked();
+	void messageReceived(quint64 requestId, const QString &action, const QJsonObject &message);
+	void messageFailed(quint64 requestId, const QString &action, Client::Error code, const QString &message ={});
+	void sendBufferFullChanged(bool full);
+
+private:
+	struct Command {
+		enum Type {
+			Connect,
+			ConnectSocket,
+			ConnectLoopback,
+			Disconnect,
+			Send,
+			SetHighWaterMark
+		} type = Send;
+		quint64 requestId = 0;
+		QString action;
+		QJsonObject message;
+		bool triggerUnlock = false;
+		qint64 highWaterMark = 0;
+		QString fallbackTarget;
+		QPointer<LoopbackServer> loopbackServer;
+	};
+
+	struct Event {
+		enum Type {
+			StateChanged,
+			Connected,
+			Disconnected,
+			Error,
+			Locked,
+			Unlocked,
+			MessageReceived,
+			MessageFailed,
+			SendBufferFullChanged
+		} type = StateChanged;
+		bool connected = false;
+		bool connecting = false;
+		bool active = false;
+		quint64 requestId = 0;
+		QString action;
+		QJsonObject message;
+		Client::Error error = Client::Error::UnknownError;
+		QString errorString;
+		bool sendBufferFull = false;
+		SecureByteArray publicKey;
+	};
+
+	QThread *_thread;
+	Connector *_connector;
+	QMetaObject::Connection _deleteConnection;
+
+	// owned by the client thread
+	SpscQueue<Command> _commands;
+	bool _connected = false;
+	bool _connecting = false;
+	bool _active = false;
+	bool _sendBufferFull = false;
+	qint64 _highWaterMark;
+	SecureByteArray _publicKey;
+	std::atomic_bool _commandsScheduled{false};
+
+	// owned by the connector thread
+	SpscQueue<Event> _events;
+	bool _publishedConnected = false;
+	bool _publishedConnecting = false;
+	bool _publishedActive = false;
+	std::atomic_bool _eventsScheduled{false};
+
+	void postCommand(Command &&command);
+	void processCommands();
+	void postEvent(Event &&event);
+	void processEvents();
+};
+
+}
+
+#endif // KPXCCLIENT_CONNECTORTHREAD_P_H
@@ -38,18 +38,15 @@ bool DefaultDatabaseRegistry::hasClientId(const QByteArray &databaseHash)
 
 IDatabaseRegistry::ClientId DefaultDatabaseRegistry::getClientId(const QByteArray &databaseHash)
 {
-	auto &clientId = d->clientIds[databaseHash];
-	SecureByteArray::StateLocker _{&clientId.key, SecureByteArray::State::Readonly};
-	return clientId;
+	return DefaultDatabaseRegistryPrivate::readableCopy(d->clientIds[databaseHash]);
 }
 
 QList<IDatabaseRegistry::ClientId> DefaultDatabaseRegistry::getAllClientIds()
 {
 	QList<ClientId> idList;
-	for(auto it = d->clientIds.begin(); it != d->clientIds.end(); ++it) {
-		SecureByteArray::StateLocker _{&it->key, SecureByteArray::State::Readonly};
-		idList.append(*it);
-	}
+	idList.reserve(d->clientIds.size());
+	for(const auto &clientId : qAsConst(d->clientIds))
+		idList.append(DefaultDatabaseRegistryPrivate::readableCopy(clientId));
 	return idList;
 }
 
@@ -143,3 +140,12 @@ void DefaultDatabaseRegistry::setPersistent(QSettings *settings, bool takeOwners
 const QString DefaultDatabaseRegistryPrivate::SettingsGroupKey{QStringLiteral("KPXCClientRegistry")};
 const QString DefaultDatabaseRegistryPrivate::SettingsNameKey{QStringLiteral("name")};
 const QString DefaultDatabaseRegistryPrivate::SettingsKeyKey{QStringLiteral("key")};
+
+IDatabaseRegistry::ClientId DefaultDatabaseRegistryPrivate::readableCopy(const IDatabaseRegistry::ClientId &clientId)
+{
+	// the stored key stays shared and sealed, callers get their own readable copy
+	if(clientId.key.isNull())
+		return clientId;
+	SecureByteArray::ReadLocker _{clientId.key};
+	return {clientId.name, SecureByteArray{clientId.key.asByteArray(), SecureByteArray::State::Readonly}};
+}
@@ -20,6 +20,8 @@ public:
 
 	QPointer<QSettings> settings;
 	QHash<QByteArray, IDatabaseRegistry::ClientId> clientIds;
+
+	static IDatabaseRegistry::ClientId readableCopy(const IDatabaseRegistry::ClientId &clientId);
 };
 
 }
@@ -0,0 +1,120 @@
+#include "envelopedecoder_p.h"
+#include <cstring>
+using namespace KPXCClient;
+
+namespace {
+
+template <size_t TSize>
+inline bool isKey(const QByteArray &key, const char (&name)[TSize]) {
+	return key.size() == static_cast<int>(TSize - 1) &&
+		   memcmp(key.constData(), name, TSize - 1) == 0;
+}
+
+}
+
+bool EnvelopeDecoder::Envelope::isSuccess() const
+{
+	if(hasSuccess)
+		return success;
+	else
+		return !hasErrorCode && !hasError;
+}
+
+bool EnvelopeDecoder::decode(const QByteArray &frame, Envelope &envelope)
+{
+	// only the fields used by the connector are read, everything else is skipped unparsed
+	envelope = {};
+	JsonReader reader{frame};
+	if(!reader.beginObject())
+		return false;
+	QByteArray key;
+	while(reader.nextKey(key)) {
+		auto ok = true;
+		if(isKey(key, "action"))
+			ok = readScalar(reader, envelope.action);
+		else if(isKey(key, "nonce"))
+			ok = readScalar(reader, envelope.nonce);
+		else if(isKey(key, "message"))
+			ok = readScalar(reader, envelope.message);
+		else if(isKey(key, "publicKey"))
+			ok = readScalar(reader, envelope.publicKey);
+		else if(isKey(key, "version"))
+			ok = readScalar(reader, envelope.version);
+		else if(isKey(key, "error")) {
+			envelope.hasError = true;
+			ok = readScalar(reader, envelope.error);
+		} else if(isKey(key, "success")) {
+			QByteArray text;
+			envelope.hasSuccess = true;
+			ok = readScalar(reader, text);
+			envelope.success = toBool(text);
+		} else if(isKey(key, "errorCode")) {
+			QByteArray text;
+			envelope.hasErrorCode = true;
+			ok = readScalar(reader, text);
+			envelope.errorCode = static_cast<int>(text.toDouble());
+		} else
+			ok = reader.skipValue();
+		if(!ok)
+			return false;
+	}
+	return !reader.hasError() && reader.atEnd();
+}
+
+EnvelopeDecoder::Envelope EnvelopeDecoder::fromObject(const QJsonObject &message)
+{
+	// for the decrypted payload, which is handed out as QJsonObject anyways
+	Envelope envelope;
+	const auto version = message.constFind(QStringLiteral("version"));
+	if(version != message.constEnd())
+		envelope.version = version->toString().toUtf8();
+	const auto success = message.constFind(QStringLiteral("success"));
+	if(success != message.constEnd()) {
+		envelope.hasSuccess = true;
+		envelope.success = success->toVariant().toBool();
+	}
+	const auto errorCode = message.constFind(QStringLiteral("errorCode"));
+	if(errorCode != message.constEnd()) {
+		envelope.hasErrorCode = true;
+		envelope.errorCode = errorCode->toVariant().toInt();
+	}
+	const auto error = message.constFind(QStringLiteral("error"));
+	if(error != message.constEnd()) {
+		envelope.hasError = true;
+		envelope.error = error->toString().toUtf8();
+	}
+	return envelope;
+}
+
+bool EnvelopeDecoder::readScalar(JsonReader &reader, QByteArray &text)
+{
+	// KeePassXC is not consistent with types, so scalars are read as their textual value
+	switch(reader.peek()) {
+	case JsonReader::Type::String:
+		return reader.readString(text);
+	case JsonReader::Type::Bool: {
+		bool value;
+		if(!reader.readBool(value))
+			return false;
+		text = value ? QByteArrayLiteral("true") : QByteArrayLiteral("false");
+		return true;
+	}
+	case JsonReader::Type::Number: {
+		double value;
+		if(!reader.readNumber(value))
+			return false;
+		text = QByteArray::number(value, 'g', 17);
+		return true;
+	}
+	default:
+		text.clear();
+		return reader.skipValue();
+	}
+}
+
+bool EnvelopeDecoder::toBool(const QByteArray &text)
+{
+	// same rules as QVariant::toBool for strings
+	const auto lower = text.toLower();
+	return !lower.isEmpty() && lower != "false" && lower != "0";
+}
@@ -0,0 +1,41 @@
+#ifndef KPXCCLIENT_ENVELOPEDECODER_P_H
+#define KPXCCLIENT_ENVELOPEDECODER_P_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonObject>
+
+#include "jsonreader_p.h"
+
+namespace KPXCClient {
+
+class EnvelopeDecoder
+{
+public:
+	// string fields are views into the decoded frame and only valid as long as it is
+	struct Envelope {
+		QByteArray action;
+		QByteArray nonce;
+		QByteArray message;
+		QByteArray publicKey;
+		QByteArray version;
+		QByteArray error;
+		int errorCode = 0;
+		bool hasSuccess = false;
+		bool success = false;
+		bool hasErrorCode = false;
+		bool hasError = false;
+
+		bool isSuccess() const;
+	};
+
+	static bool decode(const QByteArray &frame, Envelope &envelope);
+	static Envelope fromObject(const QJsonObject &message);
+
+private:
+	static bool readScalar(JsonReader &reader, QByteArray &text);
+	static bool toBool(const QByteArray &text);
+};
+
+}
+
+#endif // KPXCCLIENT_ENVELOPEDECODER_P_H
@@ -0,0 +1,76 @@
+#include "envelopeencoder_p.h"
+#include "jsonwriter_p.h"
+#include <sodium/crypto_box.h>
+#include <sodium/utils.h>
+#include <cstring>
+using namespace KPXCClient;
+
+namespace {
+
+constexpr char EnvelopeBegin[] = "{\"action\":";
+constexpr char ClientIdKey[] = ",\"clientID\":\"";
+constexpr char MessageKey[] = "\",\"message\":\"";
+constexpr char NonceKey[] = "\",\"nonce\":\"";
+constexpr char TriggerUnlockKey[] = "\",\"triggerUnlock\":\"";
+constexpr char True[] = "true";
+constexpr char False[] = "false";
+constexpr char EnvelopeEnd[] = "\"}";
+
+}
+
+bool EnvelopeEncoder::encode(FrameQueue &queue, SodiumCryptor *cryptor, const QString &action, QByteArray &plain, const SecureByteArray &nonce, const SecureByteArray &clientId, bool triggerUnlock)
+{
+	// the ciphertext replaces the plaintext in its own buffer
+	const auto plainSize = static_cast<size_t>(plain.size());
+	plain.resize(static_cast<int>(plainSize + crypto_box_MACBYTES));
+	const auto cipher = reinterpret_cast<quint8*>(plain.data());
+	if(!cryptor->encryptInPlace(cipher, plainSize, nonce.constData()))
+		return false;
+	const auto cipherSize = plainSize + crypto_box_MACBYTES;
+
+	// same layout and key order as QJsonDocument, but written once into the frame
+	QByteArray actionJson;
+	JsonWriter{actionJson}.writeString(action);
+	const auto maxSize = static_cast<qint64>(sizeof(EnvelopeBegin) + sizeof(ClientIdKey) +
+											 sizeof(MessageKey) + sizeof(NonceKey) +
+											 sizeof(TriggerUnlockKey) + sizeof(False) +
+											 sizeof(EnvelopeEnd)) +
+						 actionJson.size() +
+						 base64Size(clientId.size()) +
+						 base64Size(cipherSize) +
+						 base64Size(nonce.size());
+	const auto begin = queue.beginFrame(maxSize);
+	const auto end = begin + maxSize;
+	auto out = writeLiteral(begin, EnvelopeBegin);
+	out = writeRaw(out, actionJson.constData(), static_cast<size_t>(actionJson.size()));
+	out = writeLiteral(out, ClientIdKey);
+	out = writeBase64(out, end, clientId.constData(), clientId.size());
+	out = writeLiteral(out, MessageKey);
+	out = writeBase64(out, end, cipher, cipherSize);
+	out = writeLiteral(out, NonceKey);
+	out = writeBase64(out, end, nonce.constData(), nonce.size());
+	out = writeLiteral(out, TriggerUnlockKey);
+	out = triggerUnlock ? writeLiteral(out, True) : writeLiteral(out, False);
+	out = writeLiteral(out, EnvelopeEnd);
+	Q_ASSERT(out <= end);
+	queue.commitFrame(out - begin);
+	return true;
+}
+
+qint64 EnvelopeEncoder::base64Size(size_t size)
+{
+	// includes the terminating null byte written by sodium_bin2base64
+	return static_cast<qint64>(sodium_base64_ENCODED_LEN(size, sodium_base64_VARIANT_ORIGINAL));
+}
+
+char *EnvelopeEncoder::writeBase64(char *out, char *end, const quint8 *data, size_t size)
+{
+	sodium_bin2base64(out, static_cast<size_t>(end - out), data, size, sodium_base64_VARIANT_ORIGINAL);
+	return out + base64Size(size) - 1;
+}
+
+char *EnvelopeEncoder::writeRaw(char *out, const char *data, size_t size)
+{
+	memcpy(out, data, size);
+	return out + size;
+}
@@ -0,0 +1,36 @@
+#ifndef KPXCCLIENT_ENVELOPEENCODER_P_H
+#define KPXCCLIENT_ENVELOPEENCODER_P_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+
+#include "securebytearray.h"
+#include "framequeue_p.h"
+#include "sodiumcryptor_p.h"
+
+namespace KPXCClient {
+
+class EnvelopeEncoder
+{
+public:
+	static bool encode(FrameQueue &queue,
+					   SodiumCryptor *cryptor,
+					   const QString &action,
+					   QByteArray &plain,
+					   const SecureByteArray &nonce,
+					   const SecureByteArray &clientId,
+					   bool triggerUnlock);
+
+private:
+	static qint64 base64Size(size_t size);
+	static char *writeBase64(char *out, char *end, const quint8 *data, size_t size);
+	static char *writeRaw(char *out, const char *data, size_t size);
+	template <size_t TSize>
+	static inline char *writeLiteral(char *out, const char (&literal)[TSize]) {
+		return writeRaw(out, literal, TSize - 1);
+	}
+};
+
+}
+
+#endif // KPXCCLIENT_ENVELOPEENCODER_P_H
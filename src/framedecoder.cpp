@@ -0,0 +1,64 @@
+#include "framedecoder_p.h"
+#include <QtCore/QtEndian>
+#include <cstring>
+#include <limits>
+using namespace KPXCClient;
+
+#ifdef max
+#undef max
+#endif
+
+char *FrameDecoder::reserve(qint64 bytes)
+{
+	// move the remainder of a partial frame to the front, so the buffer never grows beyond one frame
+	if(_readPos == _writePos)
+		_readPos = _writePos = 0;
+	else if(_readPos > 0) {
+		memmove(_buffer.data(), _buffer.constData() + _readPos, static_cast<size_t>(_writePos - _readPos));
+		_writePos -= _readPos;
+		_readPos = 0;
+	}
+
+	const auto required = _writePos + bytes;
+	Q_ASSERT(required <= std::numeric_limits<int>::max());
+	if(_buffer.size() < required)
+		_buffer.resize(static_cast<int>(required));
+	return _buffer.data() + _writePos;
+}
+
+void FrameDecoder::commit(qint64 bytes)
+{
+	Q_ASSERT(_writePos + bytes <= _buffer.size());
+	_writePos += bytes;
+}
+
+FrameDecoder::Result FrameDecoder::nextFrame(QByteArray &frame)
+{
+	const auto available = _writePos - _readPos;
+	if(available < HeaderSize)
+		return Result::Incomplete;
+
+	const auto size = static_cast<qint64>(qFromUnaligned<quint32>(_buffer.constData() + _readPos));
+	if(size > MaxFrameSize) {
+		reset();
+		return Result::Invalid;
+	}
+	if(available - HeaderSize < size)
+		return Result::Incomplete;
+
+	// the frame only references the receive buffer and stays valid until the next reserve()
+	frame = QByteArray::fromRawData(_buffer.constData() + _readPos + HeaderSize, static_cast<int>(size));
+	_readPos += HeaderSize + size;
+	return Result::Frame;
+}
+
+void FrameDecoder::reset()
+{
+	_readPos = 0;
+	_writePos = 0;
+}
+
+qint64 FrameDecoder::bufferedBytes() const
+{
+	return _writePos - _readPos;
+}
@@ -0,0 +1,37 @@
+#ifndef KPXCCLIENT_FRAMEDECODER_P_H
+#define KPXCCLIENT_FRAMEDECODER_P_H
+
+#include <QtCore/QByteArray>
+
+namespace KPXCClient {
+
+class FrameDecoder
+{
+public:
+	enum class Result {
+		Incomplete,
+		Frame,
+		Invalid
+	};
+
+	static constexpr qint64 HeaderSize = sizeof(quint32);
+	// far above what KeePassXC sends, which limits native messages to 1 MiB
+	static constexpr qint64 MaxFrameSize = 16 * 1024 * 1024;
+
+	char *reserve(qint64 bytes);
+	void commit(qint64 bytes);
+
+	Result nextFrame(QByteArray &frame);
+	void reset();
+
+	qint64 bufferedBytes() const;
+
+private:
+	QByteArray _buffer;
+	qint64 _readPos = 0;
+	qint64 _writePos = 0;
+};
+
+}
+
+#endif // KPXCCLIENT_FRAMEDECODER_P_H
@@ -0,0 +1,95 @@
+#include "framequeue_p.h"
+#include <QtCore/QtEndian>
+#include <cstring>
+#include <limits>
+using namespace KPXCClient;
+
+#ifdef max
+#undef max
+#endif
+
+bool FrameQueue::isLengthPrefixed() const
+{
+	return _lengthPrefixed;
+}
+
+void FrameQueue::setLengthPrefixed(bool lengthPrefixed)
+{
+	Q_ASSERT_X(isEmpty(), Q_FUNC_INFO, "The framing cannot change while frames are queued");
+	_lengthPrefixed = lengthPrefixed;
+}
+
+void FrameQueue::enqueue(const QByteArray &payload)
+{
+	const auto out = beginFrame(payload.size());
+	memcpy(out, payload.constData(), static_cast<size_t>(payload.size()));
+	commitFrame(payload.size());
+}
+
+char *FrameQueue::beginFrame(qint64 maxSize)
+{
+	// frames are written into the write buffer directly, the header is filled in on commit
+	Q_ASSERT_X(_frameStart == -1, Q_FUNC_INFO, "The previous frame was not committed");
+	if(_gathered) {
+		_buffer.resize(0);
+		_gathered = false;
+	}
+	if(_buffer.capacity() == 0)
+		_buffer.reserve(1024); // marks the capacity as reserved, so resize(0) keeps it
+
+	_frameStart = _buffer.size();
+	const auto size = _frameStart + headerSize() + maxSize;
+	Q_ASSERT(size <= std::numeric_limits<int>::max());
+	_buffer.resize(static_cast<int>(size));
+	return _buffer.data() + _frameStart + headerSize();
+}
+
+void FrameQueue::commitFrame(qint64 size)
+{
+	Q_ASSERT_X(_frameStart != -1, Q_FUNC_INFO, "No frame was started");
+	Q_ASSERT(size <= std::numeric_limits<quint32>::max());
+	if(_lengthPrefixed)
+		qToUnaligned(static_cast<quint32>(size), _buffer.data() + _frameStart);
+	_buffer.resize(static_cast<int>(_frameStart + headerSize() + size));
+	_frameStart = -1;
+	++_frameCount;
+}
+
+const QByteArray &FrameQueue::gather()
+{
+	// the buffer already holds the frames back to back and stays valid until the next frame is started
+	Q_ASSERT_X(_frameStart == -1, Q_FUNC_INFO, "Cannot gather while a frame is being written");
+	if(_gathered)
+		_buffer.resize(0);
+	_gathered = true;
+	_frameCount = 0;
+	return _buffer;
+}
+
+void FrameQueue::clear()
+{
+	_buffer.clear();
+	_frameStart = -1;
+	_frameCount = 0;
+	_gathered = false;
+}
+
+bool FrameQueue::isEmpty() const
+{
+	return _frameCount == 0;
+}
+
+int FrameQueue::frameCount() const
+{
+	return _frameCount;
+}
+
+qint64 FrameQueue::bytesQueued() const
+{
+	return _gathered ? 0 : _buffer.size();
+}
+
+qint64 FrameQueue::headerSize() const
+{
+	return _lengthPrefixed ? HeaderSize : 0;
+}
@@ -0,0 +1,39 @@
+#ifndef KPXCCLIENT_FRAMEQUEUE_P_H
+#define KPXCCLIENT_FRAMEQUEUE_P_H
+
+#include <QtCore/QByteArray>
+
+namespace KPXCClient {
+
+class FrameQueue
+{
+public:
+	static constexpr qint64 HeaderSize = sizeof(quint32);
+
+	bool isLengthPrefixed() const;
+	void setLengthPrefixed(bool lengthPrefixed);
+
+	void enqueue(const QByteArray &payload);
+	char *beginFrame(qint64 maxSize);
+	void commitFrame(qint64 size);
+
+	const QByteArray &gather();
+	void clear();
+
+	bool isEmpty() const;
+	int frameCount() const;
+	qint64 bytesQueued() const;
+
+private:
+	QByteArray _buffer;
+	qint64 _frameStart = -1;
+	int _frameCount = 0;
+	bool _lengthPrefixed = true;
+	bool _gathered = false;
+
+	qint64 headerSize() const;
+};
+
+}
+
+#endif // KPXCCLIENT_FRAMEQUEUE_P_H
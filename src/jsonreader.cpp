@@ -0,0 +1,353 @@
+#include "jsonreader_p.h"
+#include <cstring>
+#include <cstdlib>
+using namespace KPXCClient;
+
+JsonReader::JsonReader(const QByteArray &json) :
+	_pos{json.constData()},
+	_end{json.constData() + json.size()}
+{}
+
+bool JsonReader::hasError() const
+{
+	return _error;
+}
+
+bool JsonReader::atEnd()
+{
+	skipWhitespace();
+	return _pos == _end;
+}
+
+bool JsonReader::beginObject()
+{
+	skipWhitespace();
+	if(!expect('{'))
+		return fail();
+	_firstMember = true;
+	return true;
+}
+
+bool JsonReader::nextKey(QByteArray &key)
+{
+	// returns false at the end of the object, check hasError to tell it apart from an error
+	skipWhitespace();
+	if(_pos != _end && *_pos == '}') {
+		++_pos;
+		return false;
+	}
+	if(!_firstMember) {
+		if(!expect(','))
+			return fail();
+		skipWhitespace();
+	}
+	_firstMember = false;
+	if(!readString(key))
+		return false;
+	skipWhitespace();
+	if(!expect(':'))
+		return fail();
+	return true;
+}
+
+JsonReader::Type JsonReader::peek()
+{
+	skipWhitespace();
+	if(_pos == _end)
+		return Type::Invalid;
+	switch(*_pos) {
+	case '{':
+		return Type::Object;
+	case '[':
+		return Type::Array;
+	case '"':
+		return Type::String;
+	case 't':
+	case 'f':
+		return Type::Bool;
+	case 'n':
+		return Type::Null;
+	case '-':
+	case '0': case '1': case '2': case '3': case '4':
+	case '5': case '6': case '7': case '8': case '9':
+		return Type::Number;
+	default:
+		return Type::Invalid;
+	}
+}
+
+bool JsonReader::readString(QByteArray &value)
+{
+	skipWhitespace();
+	if(!expect('"'))
+		return fail();
+
+	// strings without escapes are returned as views into the source
+	const auto begin = _pos;
+	while(_pos != _end && *_pos != '"' && *_pos != '\\')
+		++_pos;
+	if(_pos == _end)
+		return fail();
+	if(*_pos == '"') {
+		value = QByteArray::fromRawData(begin, static_cast<int>(_pos - begin));
+		++_pos;
+		return true;
+	}
+
+	QByteArray decoded{begin, static_cast<int>(_pos - begin)};
+	while(_pos != _end && *_pos != '"') {
+		if(*_pos != '\\') {
+			decoded.append(*_pos++);
+			continue;
+		}
+		if(++_pos == _end)
+			return fail();
+		switch(*_pos++) {
+		case '"':
+			decoded.append('"');
+			break;
+		case '\\':
+			decoded.append('\\');
+			break;
+		case '/':
+			decoded.append('/');
+			break;
+		case 'b':
+			decoded.append('\b');
+			break;
+		case 'f':
+			decoded.append('\f');
+			break;
+		case 'n':
+			decoded.append('\n');
+			break;
+		case 'r':
+			decoded.append('\r');
+			break;
+		case 't':
+			decoded.append('\t');
+			break;
+		case 'u': {
+			auto readHex = [this](uint &code) {
+				if(_end - _pos < 4)
+					return false;
+				code = 0;
+				for(auto i = 0; i < 4; ++i) {
+					const auto digit = hexValue(*_pos++);
+					if(digit < 0)
+						return false;
+					code = (code << 4) | static_cast<uint>(digit);
+				}
+				return true;
+			};
+			uint code = 0;
+			if(!readHex(code))
+				return fail();
+			if(code >= 0xD800 && code < 0xDC00 &&
+			   _end - _pos >= 6 && _pos[0] == '\\' && _pos[1] == 'u') {
+				_pos += 2;
+				uint low = 0;
+				if(!readHex(low))
+					return fail();
+				if(low >= 0xDC00 && low < 0xE000)
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				else {
+					appendUtf8(decoded, 0xFFFD);
+					code = low;
+				}
+			}
+			appendUtf8(decoded, code >= 0xD800 && code < 0xE000 ? 0xFFFD : code);
+			break;
+		}
+		default:
+			return fail();
+		}
+	}
+	if(_pos == _end)
+		return fail();
+	++_pos;
+	value = decoded;
+	return true;
+}
+
+bool JsonReader::readBool(bool &value)
+{
+	skipWhitespace();
+	if(skipLiteral("true", 4))
+		value = true;
+	else if(skipLiteral("false", 5))
+		value = false;
+	else
+		return fail();
+	return true;
+}
+
+bool JsonReader::readNumber(double &value)
+{
+	skipWhitespace();
+	const auto begin = _pos;
+	if(!skipNumber())
+		return false;
+	// the number is always followed by a delimiter in valid input, so strtod cannot overrun
+	const QByteArray text{begin, static_cast<int>(_pos - begin)};
+	value = std::strtod(text.constData(), nullptr);
+	return true;
+}
+
+bool JsonReader::skipValue()
+{
+	const auto type = peek();
+	switch(type) {
+	case Type::Object:
+	case Type::Array: {
+		// peers control the nesting, so it is bounded before recursing
+		if(_depth == MaxDepth)
+			return fail();
+		++_depth;
+		const auto ok = type == Type::Object ? skipObject() : skipArray();
+		--_depth;
+		return ok;
+	}
+	case Type::String:
+		return skipString();
+	case Type::Number:
+		return skipNumber();
+	case Type::Bool: {
+		bool value;
+		return readBool(value);
+	}
+	case Type::Null:
+		return skipLiteral("null", 4) || fail();
+	case Type::Invalid:
+	default:
+		return fail();
+	}
+}
+
+bool JsonReader::skipObject()
+{
+	++_pos;
+	const auto firstMember = _firstMember;
+	_firstMember = true;
+	QByteArray key;
+	while(nextKey(key)) {
+		if(!skipValue())
+			return false;
+	}
+	_firstMember = firstMember;
+	return !_error;
+}
+
+bool JsonReader::skipArray()
+{
+	++_pos;
+	skipWhitespace();
+	if(_pos != _end && *_pos == ']') {
+		++_pos;
+		return true;
+	}
+	while(true) {
+		if(!skipValue())
+			return false;
+		skipWhitespace();
+		if(_pos == _end)
+			return fail();
+		if(*_pos == ']') {
+			++_pos;
+			return true;
+		}
+		if(!expect(','))
+			return fail();
+	}
+}
+
+void JsonReader::skipWhitespace()
+{
+	while(_pos != _end && (*_pos == ' ' || *_pos == '\t' || *_pos == '\r' || *_pos == '\n'))
+		++_pos;
+}
+
+bool JsonReader::expect(char c)
+{
+	if(_pos == _end || *_pos != c)
+		return false;
+	++_pos;
+	return true;
+}
+
+bool JsonReader::fail()
+{
+	_error = true;
+	_pos = _end;
+	return false;
+}
+
+bool JsonReader::skipString()
+{
+	// skipped strings are only scanned, never decoded
+	if(!expect('"'))
+		return fail();
+	while(_pos != _end) {
+		const auto c = *_pos++;
+		if(c == '"')
+			return true;
+		else if(c == '\\') {
+			if(_pos == _end)
+				return fail();
+			++_pos;
+		}
+	}
+	return fail();
+}
+
+bool JsonReader::skipNumber()
+{
+	const auto begin = _pos;
+	if(_pos != _end && *_pos == '-')
+		++_pos;
+	while(_pos != _end &&
+		  ((*_pos >= '0' && *_pos <= '9') ||
+		   *_pos == '.' || *_pos == 'e' || *_pos == 'E' ||
+		   *_pos == '+' || *_pos == '-'))
+		++_pos;
+	return _pos != begin || fail();
+}
+
+bool JsonReader::skipLiteral(const char *literal, int size)
+{
+	if(_end - _pos < size || memcmp(_pos, literal, static_cast<size_t>(size)) != 0)
+		return false;
+	_pos += size;
+	return true;
+}
+
+void JsonReader::appendUtf8(QByteArray &out, uint code)
+{
+	if(code < 0x80)
+		out.append(static_cast<char>(code));
+	else if(code < 0x800) {
+		out.append(static_cast<char>(0xC0 | (code >> 6)));
+		out.append(static_cast<char>(0x80 | (code & 0x3F)));
+	} else if(code < 0x10000) {
+		out.append(static_cast<char>(0xE0 | (code >> 12)));
+		out.append(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+		out.append(static_cast<char>(0x80 | (code & 0x3F)));
+	} else {
+		out.append(static_cast<char>(0xF0 | (code >> 18)));
+		out.append(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+		out.append(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+		out.append(static_cast<char>(0x80 | (code & 0x3F)));
+	}
+}
+
+int JsonReader::hexValue(char c)
+{
+	if(c >= '0' && c <= '9')
+		return c - '0';
+	else if(c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	else if(c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	else
+		return -1;
+}
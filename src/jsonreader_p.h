@@ -0,0 +1,59 @@
+#ifndef KPXCCLIENT_JSONREADER_P_H
+#define KPXCCLIENT_JSONREADER_P_H
+
+#include <QtCore/QByteArray>
+
+namespace KPXCClient {
+
+class JsonReader
+{
+public:
+	enum class Type {
+		Invalid,
+		Object,
+		Array,
+		String,
+		Number,
+		Bool,
+		Null
+	};
+
+	// nesting limit for skipped values, which are skipped recursively
+	static constexpr int MaxDepth = 64;
+
+	explicit JsonReader(const QByteArray &json);
+
+	bool hasError() const;
+	bool atEnd();
+
+	bool beginObject();
+	bool nextKey(QByteArray &key);
+
+	Type peek();
+	bool readString(QByteArray &value);
+	bool readBool(bool &value);
+	bool readNumber(double &value);
+	bool skipValue();
+
+private:
+	const char *_pos;
+	const char *_end;
+	bool _error = false;
+	bool _firstMember = false;
+	int _depth = 0;
+
+	void skipWhitespace();
+	bool expect(char c);
+	bool fail();
+	bool skipObject();
+	bool skipArray();
+	bool skipString();
+	bool skipNumber();
+	bool skipLiteral(const char *literal, int size);
+	static void appendUtf8(QByteArray &out, uint code);
+	static int hexValue(char c);
+};
+
+}
+
+#endif // KPXCCLIENT_JSONREADER_P_H
@@ -0,0 +1,108 @@
+#include "jsonstreamdecoder_p.h"
+#include <cstring>
+#include <limits>
+using namespace KPXCClient;
+
+#ifdef max
+#undef max
+#endif
+
+char *JsonStreamDecoder::reserve(qint64 bytes)
+{
+	if(_readPos == _writePos)
+		_readPos = _scanPos = _writePos = 0;
+	else if(_readPos > 0) {
+		memmove(_buffer.data(), _buffer.constData() + _readPos, static_cast<size_t>(_writePos - _readPos));
+		_scanPos -= _readPos;
+		_writePos -= _readPos;
+		_readPos = 0;
+	}
+
+	const auto required = _writePos + bytes;
+	Q_ASSERT(required <= std::numeric_limits<int>::max());
+	if(_buffer.size() < required)
+		_buffer.resize(static_cast<int>(required));
+	return _buffer.data() + _writePos;
+}
+
+void JsonStreamDecoder::commit(qint64 bytes)
+{
+	Q_ASSERT(_writePos + bytes <= _buffer.size());
+	_writePos += bytes;
+}
+
+FrameDecoder::Result JsonStreamDecoder::nextFrame(QByteArray &frame)
+{
+	// the socket carries plain JSON objects back to back, so frames end with the closing brace
+	const auto data = _buffer.constData();
+	for(; _scanPos < _writePos; ++_scanPos) {
+		const auto c = data[_scanPos];
+		if(_inString) {
+			if(_escaped)
+				_escaped = false;
+			else if(c == '\\')
+				_escaped = true;
+			else if(c == '"')
+				_inString = false;
+		} else if(_depth == 0) {
+			switch(c) {
+			case '{':
+				_readPos = _scanPos;
+				_depth = 1;
+				break;
+			case ' ':
+			case '\t':
+			case '\r':
+			case '\n':
+				_readPos = _scanPos + 1;
+				break;
+			default:
+				reset();
+				return FrameDecoder::Result::Invalid;
+			}
+		} else {
+			switch(c) {
+			case '"':
+				_inString = true;
+				break;
+			case '{':
+			case '[':
+				++_depth;
+				break;
+			case '}':
+			case ']':
+				if(--_depth == 0) {
+					++_scanPos;
+					frame = QByteArray::fromRawData(data + _readPos, static_cast<int>(_scanPos - _readPos));
+					_readPos = _scanPos;
+					return FrameDecoder::Result::Frame;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	// same bound as for length prefixed frames, an unterminated object never grows the buffer further
+	if(_writePos - _readPos > FrameDecoder::MaxFrameSize) {
+		reset();
+		return FrameDecoder::Result::Invalid;
+	}
+	return FrameDecoder::Result::Incomplete;
+}
+
+void JsonStreamDecoder::reset()
+{
+	_readPos = 0;
+	_scanPos = 0;
+	_writePos = 0;
+	_depth = 0;
+	_inString = false;
+	_escaped = false;
+}
+
+qint64 JsonStreamDecoder::bufferedBytes() const
+{
+	return _writePos - _readPos;
+}
@@ -0,0 +1,34 @@
+#ifndef KPXCCLIENT_JSONSTREAMDECODER_P_H
+#define KPXCCLIENT_JSONSTREAMDECODER_P_H
+
+#include <QtCore/QByteArray>
+
+#include "framedecoder_p.h"
+
+namespace KPXCClient {
+
+class JsonStreamDecoder
+{
+public:
+	char *reserve(qint64 bytes);
+	void commit(qint64 bytes);
+
+	FrameDecoder::Result nextFrame(QByteArray &frame);
+	void reset();
+
+	qint64 bufferedBytes() const;
+
+private:
+	QByteArray _buffer;
+	qint64 _readPos = 0;
+	qint64 _scanPos = 0;
+	qint64 _writePos = 0;
+
+	int _depth = 0;
+	bool _inString = false;
+	bool _escaped = false;
+};
+
+}
+
+#endif // KPXCCLIENT_JSONSTREAMDECODER_P_H
@@ -0,0 +1,146 @@
+#include "jsonwriter_p.h"
+#include <QtCore/QLocale>
+#include <cmath>
+using namespace KPXCClient;
+
+JsonWriter::JsonWriter(QByteArray &buffer) :
+	_buffer{buffer}
+{}
+
+void JsonWriter::write(const QJsonObject &object)
+{
+	// compact output with the same key order as QJsonDocument
+	_buffer.append('{');
+	auto first = true;
+	for(auto it = object.constBegin(); it != object.constEnd(); ++it) {
+		if(!first)
+			_buffer.append(',');
+		first = false;
+		writeString(it.key());
+		_buffer.append(':');
+		write(it.value());
+	}
+	_buffer.append('}');
+}
+
+void JsonWriter::write(const QJsonArray &array)
+{
+	_buffer.append('[');
+	auto first = true;
+	for(const auto &value : array) {
+		if(!first)
+			_buffer.append(',');
+		first = false;
+		write(value);
+	}
+	_buffer.append(']');
+}
+
+void JsonWriter::write(const QJsonValue &value)
+{
+	switch(value.type()) {
+	case QJsonValue::Null:
+	case QJsonValue::Undefined:
+		_buffer.append("null");
+		break;
+	case QJsonValue::Bool:
+		_buffer.append(value.toBool() ? "true" : "false");
+		break;
+	case QJsonValue::Double: {
+		const auto number = value.toDouble();
+		if(!std::isfinite(number))
+			_buffer.append("null");
+		else if(number == std::trunc(number) && std::abs(number) < 9007199254740992.0)
+			_buffer.append(QByteArray::number(static_cast<qint64>(number)));
+		else
+			_buffer.append(QByteArray::number(number, 'g', QLocale::FloatingPointShortest));
+		break;
+	}
+	case QJsonValue::String:
+		writeString(value.toString());
+		break;
+	case QJsonValue::Array:
+		write(value.toArray());
+		break;
+	case QJsonValue::Object:
+		write(value.toObject());
+		break;
+	default:
+		Q_UNREACHABLE();
+		break;
+	}
+}
+
+void JsonWriter::writeString(const QString &text)
+{
+	// encodes UTF-16 to UTF-8 directly into the buffer instead of going through toUtf8()
+	static const char HexDigits[] = "0123456789abcdef";
+	const auto size = text.size();
+	const auto in = text.constData();
+	_buffer.append('"');
+	for(auto i = 0; i < size; ++i) {
+		const auto c = in[i].unicode();
+		if(c < 0x80) {
+			switch(c) {
+			case '"':
+				_buffer.append("\\\"");
+				break;
+			case '\\':
+				_buffer.append("\\\\");
+				break;
+			case '\b':
+				_buffer.append("\\b");
+				break;
+			case '\f':
+				_buffer.append("\\f");
+				break;
+			case '\n':
+				_buffer.append("\\n");
+				break;
+			case '\r':
+				_buffer.append("\\r");
+				break;
+			case '\t':
+				_buffer.append("\\t");
+				break;
+			default:
+				if(c < 0x20) {
+					_buffer.append("\\u00");
+					_buffer.append(HexDigits[c >> 4]);
+					_buffer.append(HexDigits[c & 0x0F]);
+				} else
+					_buffer.append(static_cast<char>(c));
+				break;
+			}
+		} else if(c < 0x800) {
+			_buffer.append(static_cast<char>(0xC0 | (c >> 6)));
+			_buffer.append(static_cast<char>(0x80 | (c & 0x3F)));
+		} else if(c >= 0xD800 && c < 0xDC00 && i + 1 < size &&
+				  in[i + 1].unicode() >= 0xDC00 && in[i + 1].unicode() < 0xE000) {
+			const auto code = 0x10000u + ((static_cast<uint>(c) - 0xD800u) << 10) + (in[++i].unicode() - 0xDC00u);
+			_buffer.append(static_cast<char>(0xF0 | (code >> 18)));
+			_buffer.append(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+			_buffer.append(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+			_buffer.append(static_cast<char>(0x80 | (code & 0x3F)));
+		} else {
+			// lone surrogates become the replacement character, like QString::toUtf8 does
+			const auto code = (c >= 0xD800 && c < 0xE000) ? 0xFFFDu : static_cast<uint>(c);
+			_buffer.append(static_cast<char>(0xE0 | (code >> 12)));
+			_buffer.append(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+			_buffer.append(static_cast<char>(0x80 | (code & 0x3F)));
+		}
+	}
+	_buffer.append('"');
+}
+
+void JsonWriter::writeRaw(const char *data, int size)
+{
+	_buffer.append(data, size);
+}
+
+QByteArray JsonWriter::toJson(const QJsonObject &object)
+{
+	QByteArray json;
+	JsonWriter{json}.write(object);
+	return json;
+}
@@ -0,0 +1,31 @@
+#ifndef KPXCCLIENT_JSONWRITER_P_H
+#define KPXCCLIENT_JSONWRITER_P_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonValue>
+
+namespace KPXCClient {
+
+class JsonWriter
+{
+public:
+	explicit JsonWriter(QByteArray &buffer);
+
+	void write(const QJsonObject &object);
+	void write(const QJsonArray &array);
+	void write(const QJsonValue &value);
+	void writeString(const QString &text);
+	void writeRaw(const char *data, int size);
+
+	static QByteArray toJson(const QJsonObject &object);
+
+private:
+	QByteArray &_buffer;
+};
+
+}
+
+#endif // KPXCCLIENT_JSONWRITER_P_H
@@ -0,0 +1,139 @@
+#include "logincache_p.h"
+#include "jsonwriter_p.h"
+#include <QtCore/QJsonDocument>
+#include <sodium/utils.h>
+#include <algorithm>
+#include <cstring>
+using namespace KPXCClient;
+
+bool LoginCache::Key::operator==(const Key &other) const
+{
+	return url == other.url &&
+		   submitUrl == other.submitUrl &&
+		   httpAuth == other.httpAuth &&
+		   searchAllDatabases == other.searchAllDatabases &&
+		   database == other.database;
+}
+
+std::chrono::milliseconds LoginCache::ttl() const
+{
+	return _ttl;
+}
+
+void LoginCache::setTtl(std::chrono::milliseconds ttl)
+{
+	_ttl = ttl;
+	clear();
+}
+
+int LoginCache::maxSize() const
+{
+	return _maxSize;
+}
+
+void LoginCache::setMaxSize(int maxSize)
+{
+	_maxSize = maxSize;
+	evict(_maxSize);
+}
+
+bool LoginCache::lookup(const Key &key, QJsonObject &message)
+{
+	auto it = _items.find(key);
+	if(it == _items.end())
+		return false;
+	if(it->expiry <= Clock::now()) {
+		_items.erase(it);
+		return false;
+	}
+
+	// the reply is only readable while it is parsed again
+	SecureByteArray::StateLocker locker{&it->json, SecureByteArray::State::Readonly};
+	message = QJsonDocument::fromJson(QByteArray::fromRawData(reinterpret_cast<const char*>(it->json.constData()),
+															  static_cast<int>(it->json.size()))).object();
+	it->lastUse = ++_useCounter;
+	return true;
+}
+
+void LoginCache::track(quint64 requestId, Key key)
+{
+	_lookups.insert(requestId, std::move(key));
+}
+
+void LoginCache::complete(quint64 requestId, const QJsonObject &message)
+{
+	// lookups sent before an invalidation were dropped with it, so stale replies are not cached
+	auto it = _lookups.find(requestId);
+	if(it == _lookups.end())
+		return;
+	const auto key = *it;
+	_lookups.erase(it);
+	insert(key, message);
+}
+
+void LoginCache::drop(quint64 requestId)
+{
+	_lookups.remove(requestId);
+}
+
+void LoginCache::clear()
+{
+	_items.clear();
+	_lookups.clear();
+}
+
+int LoginCache::size() const
+{
+	return _items.size();
+}
+
+void LoginCache::insert(const Key &key, const QJsonObject &message)
+{
+	if(_maxSize <= 0 || _ttl.count() <= 0)
+		return;
+
+	auto json = JsonWriter::toJson(message);
+	SecureByteArray secureJson{static_cast<size_t>(json.size()), SecureByteArray::State::Readwrite};
+	if(!secureJson.isNull()) {
+		memcpy(secureJson.data(), json.constData(), static_cast<size_t>(json.size()));
+		secureJson.makeNoaccess();
+	}
+	sodium_memzero(json.data(), static_cast<size_t>(json.size()));
+	// without secure memory left, the reply is simply not cached
+	if(secureJson.isNull())
+		return;
+
+	evict(_maxSize - 1);
+	_items.insert(key, {std::move(secureJson), Clock::now() + _ttl, ++_useCounter});
+}
+
+void LoginCache::evict(int maxSize)
+{
+	// expired items go first, then the least recently used ones
+	const auto now = Clock::now();
+	for(auto it = _items.begin(); it != _items.end();) {
+		if(it->expiry <= now)
+			it = _items.erase(it);
+		else
+			++it;
+	}
+	while(_items.size() > std::max(maxSize, 0)) {
+		auto oldest = _items.begin();
+		for(auto it = _items.begin(); it != _items.end(); ++it) {
+			if(it->lastUse < oldest->lastUse)
+				oldest = it;
+		}
+		_items.erase(oldest);
+	}
+}
+
+uint KPXCClient::qHash(const LoginCache::Key &key, uint seed)
+{
+	// url and submitUrl are usually equal, so they must not cancel out
+	auto hash = qHash(key.url, seed);
+	hash = hash * 31 + qHash(key.submitUrl, seed);
+	hash = hash * 31 + qHash(key.database, seed);
+	return hash * 4 +
+		   static_cast<uint>(key.httpAuth) +
+		   (static_cast<uint>(key.searchAllDatabases) << 1);
+}
@@ -0,0 +1,67 @@
+#ifndef KPXCCLIENT_LOGINCACHE_P_H
+#define KPXCCLIENT_LOGINCACHE_P_H
+
+#include <chrono>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+#include <QtCore/QString>
+
+#include "securebytearray.h"
+
+namespace KPXCClient {
+
+class LoginCache
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr std::chrono::milliseconds DefaultTtl = std::chrono::seconds{30};
+	static constexpr int DefaultMaxSize = 64;
+
+	struct Key {
+		QString url;
+		QString submitUrl;
+		bool httpAuth = false;
+		bool searchAllDatabases = false;
+		QByteArray database;
+
+		bool operator==(const Key &other) const;
+	};
+
+	std::chrono::milliseconds ttl() const;
+	void setTtl(std::chrono::milliseconds ttl);
+	int maxSize() const;
+	void setMaxSize(int maxSize);
+
+	bool lookup(const Key &key, QJsonObject &message);
+	void track(quint64 requestId, Key key);
+	void complete(quint64 requestId, const QJsonObject &message);
+	void drop(quint64 requestId);
+	void clear();
+
+	int size() const;
+
+private:
+	struct Item {
+		SecureByteArray json;
+		Clock::time_point expiry;
+		quint64 lastUse = 0;
+	};
+
+	std::chrono::milliseconds _ttl = DefaultTtl;
+	int _maxSize = DefaultMaxSize;
+	QHash<Key, Item> _items;
+	QHash<quint64, Key> _lookups;
+	quint64 _useCounter = 0;
+
+	void insert(const Key &key, const QJsonObject &message);
+	void evict(int maxSize);
+};
+
+uint qHash(const LoginCache::Key &key, uint seed = 0);
+
+}
+
+#endif // KPXCCLIENT_LOGINCACHE_P_H
@@ -0,0 +1,41 @@
+#ifndef KPXCCLIENT_LOOPBACKSERVER_H
+#define KPXCCLIENT_LOOPBACKSERVER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QScopedPointer>
+
+#include "kpxcclient_global.h"
+
+namespace KPXCClient {
+
+class LoopbackTransport;
+
+class LoopbackServerPrivate;
+class KPXCCLIENT_EXPORT LoopbackServer : public QObject
+{
+	Q_OBJECT
+
+	Q_PROPERTY(bool connected READ isConnected NOTIFY connectedChanged)
+
+public:
+	explicit LoopbackServer(QObject *parent = nullptr);
+	~LoopbackServer() override;
+
+	bool isConnected() const;
+
+public Q_SLOTS:
+	void sendMessage(const QByteArray &message);
+	void disconnectClient();
+
+Q_SIGNALS:
+	void connectedChanged(bool connected, QPrivateSignal);
+	void messageReceived(const QByteArray &message, QPrivateSignal);
+
+private:
+	friend class KPXCClient::LoopbackTransport;
+	QScopedPointer<LoopbackServerPrivate> d;
+};
+
+}
+
+#endif // KPXCCLIENT_LOOPBACKSERVER_H
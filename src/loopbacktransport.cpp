@@ -0,0 +1,238 @@
+#include "loopbackserver.h"
+#include "loopbacktransport_p.h"
+#include <QtCore/QtEndian>
+#include <cstring>
+using namespace KPXCClient;
+
+// both ends only talk via queued calls, so client and server may live on different threads.
+// The link pointers are only read under its mutex, and a side clears itself under it before
+// being destroyed, so a call can never be queued to an object that is already gone
+
+LoopbackServer::LoopbackServer(QObject *parent) :
+	QObject{parent},
+	d{new LoopbackServerPrivate{this}}
+{}
+
+LoopbackServer::~LoopbackServer()
+{
+	// in one step, so no client can attach in between
+	QMutexLocker locker{&d->link->mutex};
+	const auto transport = d->link->transport;
+	if(transport) {
+		QMetaObject::invokeMethod(transport, [transport]() {
+			transport->peerClosed();
+		}, Qt::QueuedConnection);
+	}
+	d->link->transport = nullptr;
+	d->link->server = nullptr;
+}
+
+bool LoopbackServer::isConnected() const
+{
+	QMutexLocker locker{&d->link->mutex};
+	return d->link->transport;
+}
+
+void LoopbackServer::sendMessage(const QByteArray &message)
+{
+	QByteArray data{static_cast<int>(FrameDecoder::HeaderSize + message.size()), Qt::Uninitialized};
+	qToUnaligned(static_cast<quint32>(message.size()), data.data());
+	memcpy(data.data() + FrameDecoder::HeaderSize, message.constData(), static_cast<size_t>(message.size()));
+
+	QMutexLocker locker{&d->link->mutex};
+	const auto transport = d->link->transport;
+	if(!transport)
+		return;
+	QMetaObject::invokeMethod(transport, [transport, data]() {
+		transport->deliver(data);
+	}, Qt::QueuedConnection);
+}
+
+void LoopbackServer::disconnectClient()
+{
+	{
+		QMutexLocker locker{&d->link->mutex};
+		const auto transport = d->link->transport;
+		if(!transport)
+			return;
+		QMetaObject::invokeMethod(transport, [transport]() {
+			transport->peerClosed();
+		}, Qt::QueuedConnection);
+		d->link->transport = nullptr;
+	}
+	d->decoder.reset();
+	emit connectedChanged(false, {});
+}
+
+LoopbackServerPrivate::LoopbackServerPrivate(LoopbackServer *q_ptr) :
+	q{q_ptr},
+	link{new LoopbackLink{}}
+{
+	link->server = q;
+}
+
+void LoopbackServerPrivate::receive(LoopbackTransport *sender, const QByteArray &data)
+{
+	// data of a client that was replaced in the meantime is dropped
+	if(!isCurrent(sender))
+		return;
+
+	memcpy(decoder.reserve(data.size()), data.constData(), static_cast<size_t>(data.size()));
+	decoder.commit(data.size());
+
+	QByteArray frame;
+	while(true) {
+		switch(decoder.nextFrame(frame)) {
+		case FrameDecoder::Result::Incomplete:
+			return;
+		case FrameDecoder::Result::Invalid:
+			q->disconnectClient();
+			return;
+		case FrameDecoder::Result::Frame:
+			// detach from the receive buffer, the handler may keep the message
+			emit q->messageReceived(QByteArray{frame.constData(), frame.size()}, {});
+			if(!isCurrent(sender))
+				return;
+			break;
+		default:
+			Q_UNREACHABLE();
+			break;
+		}
+	}
+}
+
+bool LoopbackServerPrivate::isCurrent(LoopbackTransport *sender) const
+{
+	QMutexLocker locker{&link->mutex};
+	return link->transport == sender;
+}
+
+LoopbackTransport::LoopbackTransport(LoopbackServer *server, QObject *parent) :
+	Transport{parent},
+	_link{server ? server->d->link : QSharedPointer<LoopbackLink>{}}
+{}
+
+LoopbackTransport::~LoopbackTransport()
+{
+	detachFromServer();
+}
+
+void LoopbackTransport::open()
+{
+	// only one client at a time, like the KeePassXC side of a proxy process
+	LoopbackServer *server = nullptr;
+	auto accepted = false;
+	if(_link) {
+		QMutexLocker locker{&_link->mutex};
+		server = _link->server;
+		if(server && !_link->transport) {
+			_link->transport = this;
+			accepted = true;
+			QMetaObject::invokeMethod(server, [server]() {
+				server->d->decoder.reset();
+				emit server->connectedChanged(true, {});
+			}, Qt::QueuedConnection);
+		}
+	}
+
+	if(!server) {
+		QMetaObject::invokeMethod(this, [this]() {
+			emit failed(tr("Loopback server does not exist"));
+		}, Qt::QueuedConnection);
+	} else {
+		QMetaObject::invokeMethod(this, [this, accepted]() {
+			this->accepted(accepted);
+		}, Qt::QueuedConnection);
+	}
+}
+
+void LoopbackTransport::closeWriteChannel()
+{
+	// there is nothing left to flush, so EOF closes the connection right away
+	kill();
+}
+
+void LoopbackTransport::terminate()
+{
+	kill();
+}
+
+void LoopbackTransport::kill()
+{
+	detachFromServer();
+	QMetaObject::invokeMethod(this, &LoopbackTransport::peerClosed, Qt::QueuedConnection);
+}
+
+qint64 LoopbackTransport::bytesToWrite() const
+{
+	return 0;
+}
+
+void LoopbackTransport::write(FrameQueue &queue)
+{
+	if(!_link || !_open)
+		return;
+
+	// deep copy, sharing the queue buffer would make it reallocate for every frame
+	const auto &buffer = queue.gather();
+	QByteArray data{buffer.constData(), buffer.size()};
+	{
+		QMutexLocker locker{&_link->mutex};
+		const auto server = _link->server;
+		if(!server || _link->transport != this)
+			return;
+		QMetaObject::invokeMethod(server, [server, self{this}, data]() {
+			server->d->receive(self, data);
+		}, Qt::QueuedConnection);
+	}
+	emit bytesWritten();
+}
+
+FrameDecoder::Result LoopbackTransport::readFrame(QByteArray &frame)
+{
+	return _decoder.nextFrame(frame);
+}
+
+void LoopbackTransport::accepted(bool accepted)
+{
+	if(accepted) {
+		_open = true;
+		emit started();
+	} else
+		emit failed(tr("Loopback server is already connected to another client"));
+}
+
+void LoopbackTransport::deliver(const QByteArray &data)
+{
+	if(!_open)
+		return;
+	memcpy(_decoder.reserve(data.size()), data.constData(), static_cast<size_t>(data.size()));
+	_decoder.commit(data.size());
+	emit readyRead();
+}
+
+void LoopbackTransport::detachFromServer()
+{
+	// synchronous, so the server never sees this transport after it was destroyed
+	if(!_link)
+		return;
+	QMutexLocker locker{&_link->mutex};
+	if(_link->transport != this)
+		return;
+	_link->transport = nullptr;
+	const auto server = _link->server;
+	if(server) {
+		QMetaObject::invokeMethod(server, [server]() {
+			server->d->decoder.reset();
+			emit server->connectedChanged(false, {});
+		}, Qt::QueuedConnection);
+	}
+}
+
+void LoopbackTransport::peerClosed()
+{
+	if(!_open)
+		return;
+	_open = false;
+	emit finished();
+}
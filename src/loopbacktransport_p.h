@@ -0,0 +1,67 @@
+#ifndef KPXCCLIENT_LOOPBACKTRANSPORT_P_H
+#define KPXCCLIENT_LOOPBACKTRANSPORT_P_H
+
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
+
+#include "transport_p.h"
+#include "framedecoder_p.h"
+#include "loopbackserver.h"
+
+namespace KPXCClient {
+
+// shared by the server and its transports, which may live on different threads
+struct LoopbackLink
+{
+	QMutex mutex;
+	LoopbackServer *server = nullptr;
+	LoopbackTransport *transport = nullptr;
+};
+
+class LoopbackServerPrivate
+{
+public:
+	LoopbackServer * const q;
+	const QSharedPointer<LoopbackLink> link;
+	FrameDecoder decoder;
+
+	LoopbackServerPrivate(LoopbackServer *q_ptr);
+
+	bool isCurrent(LoopbackTransport *sender) const;
+	void receive(LoopbackTransport *sender, const QByteArray &data);
+};
+
+class LoopbackTransport : public Transport
+{
+	Q_OBJECT
+
+public:
+	explicit LoopbackTransport(LoopbackServer *server, QObject *parent = nullptr);
+	~LoopbackTransport() override;
+
+	void open() override;
+	void closeWriteChannel() override;
+	void terminate() override;
+	void kill() override;
+
+	qint64 bytesToWrite() const override;
+	void write(FrameQueue &queue) override;
+	FrameDecoder::Result readFrame(QByteArray &frame) override;
+
+private:
+	friend class LoopbackServer;
+	friend class LoopbackServerPrivate;
+
+	QSharedPointer<LoopbackLink> _link;
+	FrameDecoder _decoder;
+	bool _open = false;
+
+	void accepted(bool accepted);
+	void deliver(const QByteArray &data);
+	void detachFromServer();
+	void peerClosed();
+};
+
+}
+
+#endif // KPXCCLIENT_LOOPBACKTRANSPORT_P_H
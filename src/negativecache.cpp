@@ -0,0 +1,152 @@
+#include "negativecache_p.h"
+using namespace KPXCClient;
+
+std::chrono::milliseconds NegativeCache::ttl() const
+{
+	return _ttl;
+}
+
+void NegativeCache::setTtl(std::chrono::milliseconds ttl)
+{
+	_ttl = ttl;
+	clear();
+}
+
+bool NegativeCache::lookup(const QString &host, const Key &key, QString &message)
+{
+	// hosts that never missed are rejected without hashing the full key
+	if(!mayContain(host))
+		return false;
+
+	auto it = _items.find(key);
+	if(it == _items.end())
+		return false;
+	if(it->expiry <= Clock::now()) {
+		_items.erase(it);
+		return false;
+	}
+	message = it->message;
+	return true;
+}
+
+void NegativeCache::track(quint64 requestId, const QString &host, Key key)
+{
+	_lookups.insert(requestId, {host, std::move(key)});
+}
+
+void NegativeCache::trackAdd(quint64 requestId, const QString &host)
+{
+	// lookups for the host that are still in flight were answered before the new login exists
+	for(auto it = _lookups.begin(); it != _lookups.end();) {
+		if(it->host == host)
+			it = _lookups.erase(it);
+		else
+			++it;
+	}
+	_adds.insert(requestId, host);
+}
+
+void NegativeCache::complete(quint64 requestId)
+{
+	if(!_lookups.remove(requestId)) {
+		auto it = _adds.find(requestId);
+		if(it != _adds.end()) {
+			removeHost(*it);
+			_adds.erase(it);
+		}
+	}
+}
+
+void NegativeCache::fail(quint64 requestId, bool noLoginsFound, const QString &message)
+{
+	_adds.remove(requestId);
+	auto it = _lookups.find(requestId);
+	if(it == _lookups.end())
+		return;
+	const auto lookup = *it;
+	_lookups.erase(it);
+	if(!noLoginsFound || _ttl.count() <= 0)
+		return;
+
+	const auto now = Clock::now();
+	if(_items.size() >= MaxSize && !_items.contains(lookup.key))
+		purge(now);
+	_items.insert(lookup.key, {lookup.host, message, now + _ttl});
+	addToBloom(lookup.host);
+}
+
+void NegativeCache::clear()
+{
+	_items.clear();
+	_lookups.clear();
+	_adds.clear();
+	_bloom.reset();
+}
+
+int NegativeCache::size() const
+{
+	return _items.size();
+}
+
+void NegativeCache::removeHost(const QString &host)
+{
+	if(!mayContain(host))
+		return;
+	for(auto it = _items.begin(); it != _items.end();) {
+		if(it->host == host)
+			it = _items.erase(it);
+		else
+			++it;
+	}
+	rebuildBloom();
+}
+
+void NegativeCache::purge(Clock::time_point now)
+{
+	// drop expired misses, or the one closest to expiry if all are still valid
+	auto soonest = _items.end();
+	for(auto it = _items.begin(); it != _items.end();) {
+		if(it->expiry <= now)
+			it = _items.erase(it);
+		else {
+			if(soonest == _items.end() || it->expiry < soonest->expiry)
+				soonest = it;
+			++it;
+		}
+	}
+	if(_items.size() >= MaxSize && soonest != _items.end())
+		_items.erase(soonest);
+	rebuildBloom();
+}
+
+void NegativeCache::addToBloom(const QString &host)
+{
+	const auto h1 = qHash(host, 0);
+	const auto h2 = qHash(host, 0x9e3779b9u) | 1u;
+	for(auto i = 0; i < BloomHashes; ++i)
+		_bloom.set(bloomIndex(h1, h2, i));
+}
+
+bool NegativeCache::mayContain(const QString &host) const
+{
+	const auto h1 = qHash(host, 0);
+	const auto h2 = qHash(host, 0x9e3779b9u) | 1u;
+	for(auto i = 0; i < BloomHashes; ++i) {
+		if(!_bloom.test(bloomIndex(h1, h2, i)))
+			return false;
+	}
+	return true;
+}
+
+void NegativeCache::rebuildBloom()
+{
+	// bloom filters cannot forget, so removals rebuild it from the remaining misses
+	_bloom.reset();
+	for(const auto &item : qAsConst(_items))
+		addToBloom(item.host);
+}
+
+size_t NegativeCache::bloomIndex(uint h1, uint h2, int i)
+{
+	return (h1 + static_cast<uint>(i) * h2) % BloomBits;
+}
@@ -0,0 +1,66 @@
+#ifndef KPXCCLIENT_NEGATIVECACHE_P_H
+#define KPXCCLIENT_NEGATIVECACHE_P_H
+
+#include <bitset>
+#include <chrono>
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+
+#include "logincache_p.h"
+
+namespace KPXCClient {
+
+class NegativeCache
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Key = LoginCache::Key;
+
+	static constexpr std::chrono::milliseconds DefaultTtl = std::chrono::seconds{5};
+	static constexpr int MaxSize = 1024;
+
+	std::chrono::milliseconds ttl() const;
+	void setTtl(std::chrono::milliseconds ttl);
+
+	bool lookup(const QString &host, const Key &key, QString &message);
+	void track(quint64 requestId, const QString &host, Key key);
+	void trackAdd(quint64 requestId, const QString &host);
+	void complete(quint64 requestId);
+	void fail(quint64 requestId, bool noLoginsFound, const QString &message);
+	void clear();
+
+	int size() const;
+
+private:
+	static constexpr size_t BloomBits = 4096;
+	static constexpr int BloomHashes = 3;
+
+	struct Item {
+		QString host;
+		QString message;
+		Clock::time_point expiry;
+	};
+
+	struct Lookup {
+		QString host;
+		Key key;
+	};
+
+	std::chrono::milliseconds _ttl = DefaultTtl;
+	QHash<Key, Item> _items;
+	QHash<quint64, Lookup> _lookups;
+	QHash<quint64, QString> _adds;
+	std::bitset<BloomBits> _bloom;
+
+	void removeHost(const QString &host);
+	void purge(Clock::time_point now);
+	void addToBloom(const QString &host);
+	bool mayContain(const QString &host) const;
+	void rebuildBloom();
+	static size_t bloomIndex(uint h1, uint h2, int i);
+};
+
+}
+
+#endif // KPXCCLIENT_NEGATIVECACHE_P_H
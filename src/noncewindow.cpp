@@ -0,0 +1,124 @@
+#include "noncewindow_p.h"
+#include <QtCore/QtEndian>
+using namespace KPXCClient;
+
+void NonceWindow::insert(const Nonce &nonce, Request request, Clock::time_point deadline)
+{
+	Q_ASSERT_X(!isFull(), Q_FUNC_INFO, "The nonce window is full");
+	auto index = homeOf(nonce);
+	while(_slots[index].used && _slots[index].nonce != nonce)
+		index = (index + 1) & TableMask;
+
+	auto &slot = _slots[index];
+	if(!slot.used)
+		++_size;
+	slot.nonce = nonce;
+	slot.request = std::move(request);
+	slot.deadline = deadline;
+	slot.used = true;
+}
+
+NonceWindow::Request NonceWindow::take(const Nonce &nonce)
+{
+	const auto index = indexOf(nonce);
+	return index == -1 ? Request{} : takeAt(static_cast<quint32>(index));
+}
+
+NonceWindow::Request NonceWindow::takeOldest(const QString &action)
+{
+	auto oldest = -1;
+	for(quint32 i = 0; i < TableSize; ++i) {
+		if(_slots[i].used && _slots[i].request.action == action &&
+		   (oldest == -1 || _slots[i].request.id < _slots[oldest].request.id))
+			oldest = static_cast<int>(i);
+	}
+	return oldest == -1 ? Request{} : takeAt(static_cast<quint32>(oldest));
+}
+
+bool NonceWindow::takeTombstone(const Nonce &nonce)
+{
+	// only searched for replies without a pending request, so a linear scan is enough
+	for(auto i = 0; i < _tombstoneCount; ++i) {
+		auto &tombstone = _tombstones[static_cast<size_t>(i)];
+		if(tombstone.used && tombstone.nonce == nonce) {
+			tombstone.used = false;
+			return true;
+		}
+	}
+	return false;
+}
+
+void NonceWindow::clear()
+{
+	for(auto &slot : _slots) {
+		slot.used = false;
+		slot.request = {};
+	}
+	_size = 0;
+	for(auto &tombstone : _tombstones)
+		tombstone.used = false;
+	_tombstoneCount = 0;
+	_tombstoneNext = 0;
+}
+
+int NonceWindow::size() const
+{
+	return _size;
+}
+
+bool NonceWindow::isEmpty() const
+{
+	return _size == 0;
+}
+
+bool NonceWindow::isFull() const
+{
+	return _size == Capacity;
+}
+
+quint32 NonceWindow::homeOf(const Nonce &nonce)
+{
+	// nonces are random, but replies increment the low bytes, so hash the stable middle part
+	return qFromUnaligned<quint32>(nonce.data() + 8) & TableMask;
+}
+
+int NonceWindow::indexOf(const Nonce &nonce) const
+{
+	for(auto index = homeOf(nonce); _slots[index].used; index = (index + 1) & TableMask) {
+		if(_slots[index].nonce == nonce)
+			return static_cast<int>(index);
+	}
+	return -1;
+}
+
+NonceWindow::Request NonceWindow::takeAt(quint32 index)
+{
+	auto request = std::move(_slots[index].request);
+	_slots[index].request = {};
+	_slots[index].used = false;
+	--_size;
+
+	// backward shift deletion: move following entries of the probe sequence into the gap
+	auto gap = index;
+	for(auto next = (gap + 1) & TableMask; _slots[next].used; next = (next + 1) & TableMask) {
+		const auto home = homeOf(_slots[next].nonce);
+		const auto stays = gap <= next ?
+							   gap < home && home <= next :
+							   gap < home || home <= next;
+		if(stays)
+			continue;
+		_slots[gap] = std::move(_slots[next]);
+		_slots[next].request = {};
+		_slots[next].used = false;
+		gap = next;
+	}
+	return request;
+}
+
+void NonceWindow::addTombstone(const Nonce &nonce)
+{
+	// the oldest tombstone is overwritten once the ring is full
+	_tombstones[static_cast<size_t>(_tombstoneNext)] = {nonce, true};
+	_tombstoneNext = (_tombstoneNext + 1) % TombstoneCapacity;
+	_tombstoneCount = qMin(_tombstoneCount + 1, TombstoneCapacity);
+}
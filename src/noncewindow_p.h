@@ -0,0 +1,85 @@
+#ifndef KPXCCLIENT_NONCEWINDOW_P_H
+#define KPXCCLIENT_NONCEWINDOW_P_H
+
+#include <array>
+#include <chrono>
+
+#include <QtCore/QString>
+
+#include <sodium/crypto_box.h>
+
+namespace KPXCClient {
+
+class NonceWindow
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Nonce = std::array<quint8, crypto_box_NONCEBYTES>;
+
+	static constexpr int Capacity = 256;
+	static constexpr int TombstoneCapacity = 256;
+
+	struct Request {
+		quint64 id = 0;
+		QString action;
+	};
+
+	void insert(const Nonce &nonce, Request request, Clock::time_point deadline);
+	Request take(const Nonce &nonce);
+	Request takeOldest(const QString &action);
+	template <typename TFunc>
+	void expire(Clock::time_point now, TFunc &&onExpired);
+	bool takeTombstone(const Nonce &nonce);
+	void clear();
+
+	int size() const;
+	bool isEmpty() const;
+	bool isFull() const;
+
+private:
+	// open addressing at a load factor of at most 0.5 keeps probe sequences short
+	static constexpr quint32 TableSize = Capacity * 2;
+	static constexpr quint32 TableMask = TableSize - 1;
+
+	struct Slot {
+		Nonce nonce;
+		Request request;
+		Clock::time_point deadline;
+		bool used = false;
+	};
+
+	std::array<Slot, TableSize> _slots;
+	int _size = 0;
+
+	// nonces of expired requests, so their late replies can be told apart from invalid ones
+	struct Tombstone {
+		Nonce nonce;
+		bool used = false;
+	};
+
+	std::array<Tombstone, TombstoneCapacity> _tombstones;
+	int _tombstoneCount = 0;
+	int _tombstoneNext = 0;
+
+	static quint32 homeOf(const Nonce &nonce);
+	int indexOf(const Nonce &nonce) const;
+	Request takeAt(quint32 index);
+	void addTombstone(const Nonce &nonce);
+};
+
+template <typename TFunc>
+void NonceWindow::expire(Clock::time_point now, TFunc &&onExpired)
+{
+	for(quint32 i = 0; i < TableSize && _size > 0;) {
+		// taking a slot can shift a later entry into it, so only advance if nothing was taken
+		if(_slots[i].used && _slots[i].deadline <= now) {
+			addTombstone(_slots[i].nonce);
+			onExpired(takeAt(i));
+		} else
+			++i;
+	}
+}
+
+}
+
+#endif // KPXCCLIENT_NONCEWINDOW_P_H
@@ -0,0 +1,83 @@
+#include "processtransport_p.h"
+#include <QtCore/QDebug>
+using namespace KPXCClient;
+
+ProcessTransport::ProcessTransport(const QString &program, QObject *parent) :
+	Transport{parent},
+	_process{new QProcess{this}}
+{
+	_process->setProgram(program);
+	connect(_process, &QProcess::started,
+			this, &ProcessTransport::started);
+	connect(_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+			this, &ProcessTransport::procFinished);
+	connect(_process, &QProcess::errorOccurred,
+			this, &ProcessTransport::procError);
+	connect(_process, &QProcess::readyReadStandardOutput,
+			this, &ProcessTransport::readyRead);
+	connect(_process, &QProcess::readyReadStandardError,
+			this, &ProcessTransport::stdErrReady);
+	connect(_process, &QProcess::bytesWritten,
+			this, &ProcessTransport::bytesWritten);
+}
+
+void ProcessTransport::open()
+{
+	_process->start();
+}
+
+void ProcessTransport::closeWriteChannel()
+{
+	_process->closeWriteChannel();
+}
+
+void ProcessTransport::terminate()
+{
+	_process->terminate();
+}
+
+void ProcessTransport::kill()
+{
+	_process->kill();
+}
+
+qint64 ProcessTransport::bytesToWrite() const
+{
+	return _process->bytesToWrite();
+}
+
+void ProcessTransport::write(FrameQueue &queue)
+{
+	_process->write(queue.gather());
+}
+
+FrameDecoder::Result ProcessTransport::readFrame(QByteArray &frame)
+{
+	// append everything available to the receive buffer
+	const auto available = _process->bytesAvailable();
+	if(available > 0) {
+		const auto bytesRead = _process->read(_decoder.reserve(available), available);
+		_decoder.commit(qMax<qint64>(bytesRead, 0));
+	}
+	return _decoder.nextFrame(frame);
+}
+
+void ProcessTransport::procFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+	qInfo() << "Connection closed with code:" << exitCode
+			<< "(Status:" << exitStatus << ")";
+	emit finished();
+}
+
+void ProcessTransport::procError(QProcess::ProcessError error)
+{
+	qCritical() << error << _process->errorString();
+	// a process that never started will not report finished
+	if(error == QProcess::FailedToStart)
+		emit failed(_process->errorString());
+}
+
+void ProcessTransport::stdErrReady()
+{
+	qWarning() << "stderr" << _process->readAllStandardError();
+}
@@ -0,0 +1,39 @@
+#ifndef KPXCCLIENT_PROCESSTRANSPORT_P_H
+#define KPXCCLIENT_PROCESSTRANSPORT_P_H
+
+#include <QtCore/QProcess>
+
+#include "transport_p.h"
+#include "framedecoder_p.h"
+
+namespace KPXCClient {
+
+class ProcessTransport : public Transport
+{
+	Q_OBJECT
+
+public:
+	explicit ProcessTransport(const QString &program, QObject *parent = nullptr);
+
+	void open() override;
+	void closeWriteChannel() override;
+	void terminate() override;
+	void kill() override;
+
+	qint64 bytesToWrite() const override;
+	void write(FrameQueue &queue) override;
+	FrameDecoder::Result readFrame(QByteArray &frame) override;
+
+private Q_SLOTS:
+	void procFinished(int exitCode, QProcess::ExitStatus exitStatus);
+	void procError(QProcess::ProcessError error);
+	void stdErrReady();
+
+private:
+	QProcess *_process;
+	FrameDecoder _decoder;
+};
+
+}
+
+#endif // KPXCCLIENT_PROCESSTRANSPORT_P_H
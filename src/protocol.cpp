@@ -0,0 +1,64 @@
+#include "protocol_p.h"
+#include <array>
+#include <cstring>
+using namespace KPXCClient;
+using namespace KPXCClient::Protocol;
+
+namespace {
+
+inline uint charCode(char c) {
+	return static_cast<uchar>(c);
+}
+
+inline uint charCode(QChar c) {
+	return c.unicode();
+}
+
+template <typename TChar>
+Action lookup(const TChar *name, int size)
+{
+	// one hash, one table probe and one compare to reject unknown names
+	auto hash = Hash::seeded(Hash::ActionTable.seed);
+	for(auto i = 0; i < size; ++i) {
+		const auto c = charCode(name[i]);
+		if(c >= 0x80)
+			return Action::Unknown;
+		hash = Hash::step(hash, c);
+	}
+
+	const auto action = Hash::ActionTable.slots[hash % Hash::TableSize];
+	if(action == Action::Unknown)
+		return Action::Unknown;
+	const auto expected = ActionNames[actionIndex(action)];
+	if(static_cast<int>(strlen(expected)) != size)
+		return Action::Unknown;
+	for(auto i = 0; i < size; ++i) {
+		if(charCode(name[i]) != charCode(expected[i]))
+			return Action::Unknown;
+	}
+	return action;
+}
+
+}
+
+const QString &Protocol::actionName(Action action)
+{
+	static const auto names = []() {
+		std::array<QString, ActionCount + 1> result;
+		for(auto i = 0; i < ActionCount; ++i)
+			result[static_cast<size_t>(i)] = QString::fromLatin1(ActionNames[i]);
+		return result;
+	}();
+	Q_ASSERT(action <= Action::Unknown);
+	return names[actionIndex(action)];
+}
+
+Action Protocol::actionFromName(const QString &name)
+{
+	return lookup(name.constData(), name.size());
+}
+
+Action Protocol::actionFromName(const QByteArray &name)
+{
+	return lookup(name.constData(), name.size());
+}
@@ -0,0 +1,317 @@
+#ifndef KPXCCLIENT_PROTOCOL_P_H
+#define KPXCCLIENT_PROTOCOL_P_H
+
+#include <tuple>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonValue>
+#include <QtCore/QVariant>
+
+namespace KPXCClient {
+namespace Protocol {
+
+enum class Action : quint8 {
+	ChangePublicKeys,
+	DatabaseLocked,
+	DatabaseUnlocked,
+	GetDatabaseHash,
+	TestAssociate,
+	Associate,
+	GeneratePassword,
+	GetLogins,
+	SetLogin,
+	LockDatabase,
+
+	Unknown
+};
+
+constexpr int ActionCount = static_cast<int>(Action::Unknown);
+
+constexpr size_t actionIndex(Action action) {
+	return static_cast<size_t>(action);
+}
+
+// indexed by Action
+constexpr const char *ActionNames[ActionCount] = {
+	"change-public-keys",
+	"database-locked",
+	"database-unlocked",
+	"get-databasehash",
+	"test-associate",
+	"associate",
+	"generate-password",
+	"get-logins",
+	"set-login",
+	"lock-database"
+};
+
+const QString &actionName(Action action);
+Action actionFromName(const QString &name);
+Action actionFromName(const QByteArray &name);
+
+// ------------- perfect hash over the action names -------------
+
+namespace Hash {
+
+constexpr int TableSize = 32;
+
+constexpr quint32 step(quint32 hash, uint c) {
+	return (hash ^ c) * 16777619u;
+}
+
+constexpr quint32 seeded(quint32 seed) {
+	return 2166136261u ^ seed;
+}
+
+constexpr quint32 hash(const char *name, quint32 seed) {
+	auto value = seeded(seed);
+	while(*name)
+		value = step(value, static_cast<uchar>(*name++));
+	return value;
+}
+
+struct Table {
+	quint32 seed = 0;
+	Action slots[TableSize] = {};
+	bool perfect = false;
+};
+
+constexpr Table tryBuild(quint32 seed) {
+	Table table;
+	table.seed = seed;
+	table.perfect = true;
+	for(auto &slot : table.slots)
+		slot = Action::Unknown;
+	for(auto i = 0; i < ActionCount; ++i) {
+		auto &slot = table.slots[hash(ActionNames[i], seed) % TableSize];
+		if(slot != Action::Unknown)
+			table.perfect = false;
+		slot = static_cast<Action>(i);
+	}
+	return table;
+}
+
+constexpr Table build() {
+	// searches the first seed without collisions, so new actions need no manual tuning
+	for(quint32 seed = 0; seed < 4096; ++seed) {
+		const auto table = tryBuild(seed);
+		if(table.perfect)
+			return table;
+	}
+	return {};
+}
+
+constexpr Table ActionTable = build();
+static_assert(ActionTable.perfect, "No collision free seed found for the action names, increase Hash::TableSize");
+
+}
+
+// ------------- compile time field tables -------------
+
+template <typename TMessage, typename TValue>
+struct Field {
+	const char *name;
+	int size;
+	TValue TMessage::*member;
+	bool optional;
+
+	constexpr QLatin1String key() const {
+		return QLatin1String{name, size};
+	}
+};
+
+template <typename TMessage, typename TValue, size_t TSize>
+constexpr Field<TMessage, TValue> field(const char (&name)[TSize], TValue TMessage::*member, bool optional = false) {
+	return {name, static_cast<int>(TSize - 1), member, optional};
+}
+
+// the protocol transfers booleans as strings
+inline QJsonValue toValue(const QString &value) {
+	return value;
+}
+
+inline QJsonValue toValue(const QJsonArray &value) {
+	return value;
+}
+
+inline QJsonValue toValue(bool value) {
+	return value ? QStringLiteral("true") : QStringLiteral("false");
+}
+
+inline void fromValue(const QJsonValue &json, QString &value) {
+	value = json.toString();
+}
+
+inline void fromValue(const QJsonValue &json, QJsonArray &value) {
+	value = json.toArray();
+}
+
+inline void fromValue(const QJsonValue &json, bool &value) {
+	value = json.toVariant().toBool();
+}
+
+template <typename TValue>
+inline bool isEmptyValue(const TValue &value) {
+	return value.isEmpty();
+}
+
+inline bool isEmptyValue(bool) {
+	return false;
+}
+
+template <typename TMessage>
+QJsonObject toJson(const TMessage &message)
+{
+	QJsonObject object;
+	std::apply([&](const auto &...fields) {
+		const auto write = [&](const auto &field) {
+			const auto &value = message.*field.member;
+			if(!field.optional || !isEmptyValue(value))
+				object[field.key()] = toValue(value);
+		};
+		(write(fields), ...);
+		Q_UNUSED(write)
+	}, TMessage::fields());
+	return object;
+}
+
+template <typename TMessage>
+TMessage fromJson(const QJsonObject &object)
+{
+	TMessage message;
+	std::apply([&](const auto &...fields) {
+		const auto read = [&](const auto &field) {
+			const auto it = object.constFind(field.key());
+			if(it != object.constEnd())
+				fromValue(*it, message.*field.member);
+		};
+		(read(fields), ...);
+		Q_UNUSED(read)
+	}, TMessage::fields());
+	return message;
+}
+
+// ------------- messages -------------
+
+struct ChangePublicKeysRequest {
+	static constexpr Action Id = Action::ChangePublicKeys;
+	QString publicKey;
+	QString nonce;
+	QString clientID;
+
+	static constexpr auto fields() {
+		return std::make_tuple(field("publicKey", &ChangePublicKeysRequest::publicKey),
+							   field("nonce", &ChangePublicKeysRequest::nonce),
+							   field("clientID", &ChangePublicKeysRequest::clientID));
+	}
+};
+
+struct GetDatabaseHashRequest {
+	static constexpr Action Id = Action::GetDatabaseHash;
+
+	static constexpr auto fields() {
+		return std::make_tuple();
+	}
+};
+
+struct DatabaseHashReply {
+	static constexpr Action Id = Action::GetDatabaseHash;
+	QString hash;
+
+	static constexpr auto fields() {
+		return std::make_tuple(field("hash", &DatabaseHashReply::hash));
+	}
+};
+
+struct TestAssociateRequest {
+	static constexpr Action Id = Action::TestAssociate;
+	QString id;
+	QString key;
+
+	static constexpr auto fields() {
+		return std::make_tuple(field("id", &TestAssociateRequest::id),
+							   field("key", &TestAssociateRequest::key));
+	}
+};
+
+struct AssociateRequest {
+	static constexpr Action Id = Action::Associate;
+	QString key;
+	QString idKey;
+
+	static constexpr auto fields() {
+		return std::make_tuple(field("key", &AssociateRequest::key),
+							   field("idKey", &AssociateRequest::idKey));
+	}
+};
+
+// test-associate and associate reply with the same fields
+struct AssociateReply {
+	QString hash;
+	QString id;
+
+	static constexpr auto fields() {
+		return std::make_tuple(field("hash", &AssociateReply::hash),
+							   field("id", &AssociateReply::id));
+	}
+};
+
+struct GeneratePasswordRequest {
+	static constexpr Action Id = Action::GeneratePassword;
+
+	static constexpr auto fields() {
+		return std::make_tuple();
+	}
+};
+
+struct GetLoginsRequest {
+	static constexpr Action Id = Action::GetLogins;
+	QString id;
+	QString url;
+	QString submitUrl;
+	bool httpAuth = false;
+	QJsonArray keys;
+
+	static constexpr auto fields() {
+		return std::make_tuple(field("id", &GetLoginsRequest::id),
+							   field("url", &GetLoginsRequest::url),
+							   field("submitUrl", &GetLoginsRequest::submitUrl),
+							   field("httpAuth", &GetLoginsRequest::httpAuth),
+							   field("keys", &GetLoginsRequest::keys));
+	}
+};
+
+struct SetLoginRequest {
+	static constexpr Action Id = Action::SetLogin;
+	QString id;
+	QString url;
+	QString submitUrl;
+	QString uuid;
+	QString login;
+	QString password;
+
+	static constexpr auto fields() {
+		return std::make_tuple(field("id", &SetLoginRequest::id),
+							   field("url", &SetLoginRequest::url),
+							   field("submitUrl", &SetLoginRequest::submitUrl),
+							   field("uuid", &SetLoginRequest::uuid, true),
+							   field("login", &SetLoginRequest::login),
+							   field("password", &SetLoginRequest::password));
+	}
+};
+
+struct LockDatabaseRequest {
+	static constexpr Action Id = Action::LockDatabase;
+
+	static constexpr auto fields() {
+		return std::make_tuple();
+	}
+};
+
+}
+}
+
+#endif // KPXCCLIENT_PROTOCOL_P_H
@@ -0,0 +1,91 @@
+#include "randompool_p.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <sodium/crypto_stream_chacha20.h>
+#include <sodium/randombytes.h>
+#include <sodium/utils.h>
+#ifdef Q_OS_UNIX
+#include <pthread.h>
+#endif
+using namespace KPXCClient;
+
+namespace {
+
+// incremented in forked children, so pools never hand out the parents stream twice
+std::atomic<quint64> forkGeneration{0};
+
+quint64 currentForkGeneration()
+{
+#ifdef Q_OS_UNIX
+	static std::once_flag registered;
+	std::call_once(registered, []() {
+		pthread_atfork(nullptr, nullptr, []() {
+			++forkGeneration;
+		});
+	});
+#endif
+	return forkGeneration.load(std::memory_order_relaxed);
+}
+
+}
+
+RandomPool::RandomPool() :
+	_key{crypto_stream_chacha20_KEYBYTES},
+	_buffer{BufferSize}
+{
+	if(isValid())
+		reseed();
+}
+
+bool RandomPool::isValid() const
+{
+	return !_key.isNull() && !_buffer.isNull();
+}
+
+void RandomPool::fill(quint8 *out, size_t size)
+{
+	// without secure memory for the pool, every request goes to the system generator
+	if(!isValid()) {
+		randombytes_buf(out, size);
+		return;
+	}
+
+	if(_forkGeneration != currentForkGeneration() ||
+	   _bytesSinceReseed >= ReseedInterval)
+		reseed();
+
+	while(size > 0) {
+		if(_position == _buffer.size())
+			refill();
+		const auto chunk = qMin(size, _buffer.size() - _position);
+		// served bytes are wiped, so they cannot be recovered from the pool later
+		memcpy(out, _buffer.constData() + _position, chunk);
+		sodium_memzero(_buffer.data() + _position, chunk);
+		_position += chunk;
+		out += chunk;
+		size -= chunk;
+	}
+}
+
+void RandomPool::reseed()
+{
+	if(!isValid())
+		return;
+	randombytes_buf(_key.data(), _key.size());
+	sodium_memzero(_buffer.data(), _buffer.size());
+	_position = _buffer.size();
+	_bytesSinceReseed = 0;
+	_forkGeneration = currentForkGeneration();
+}
+
+void RandomPool::refill()
+{
+	// fast key erasure: the first block of every refill becomes the next key
+	static const quint8 nonce[crypto_stream_chacha20_NONCEBYTES] = {};
+	crypto_stream_chacha20(_buffer.data(), _buffer.size(), nonce, _key.constData());
+	memcpy(_key.data(), _buffer.constData(), _key.size());
+	sodium_memzero(_buffer.data(), _key.size());
+	_position = _key.size();
+	_bytesSinceReseed += _buffer.size() - _key.size();
+}
@@ -0,0 +1,34 @@
+#ifndef KPXCCLIENT_RANDOMPOOL_P_H
+#define KPXCCLIENT_RANDOMPOOL_P_H
+
+#include <QtCore/QtGlobal>
+
+#include "securebytearray.h"
+
+namespace KPXCClient {
+
+class RandomPool
+{
+public:
+	static constexpr size_t BufferSize = 4096;
+	static constexpr quint64 ReseedInterval = 1024 * 1024;
+
+	RandomPool();
+
+	bool isValid() const;
+	void fill(quint8 *out, size_t size);
+	void reseed();
+
+private:
+	SecureByteArray _key;
+	SecureByteArray _buffer;
+	size_t _position = BufferSize;
+	quint64 _bytesSinceReseed = 0;
+	quint64 _forkGeneration = 0;
+
+	void refill();
+};
+
+}
+
+#endif // KPXCCLIENT_RANDOMPOOL_P_H
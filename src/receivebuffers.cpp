@@ -0,0 +1,85 @@
+#include "receivebuffers_p.h"
+#include <sodium/utils.h>
+#include <algorithm>
+#include <limits>
+using namespace KPXCClient;
+
+#ifdef max
+#undef max
+#endif
+
+QByteArray ReceiveBuffers::decodeBase64(const QByteArray &text)
+{
+	// the result only references the cipher buffer and stays valid until the next call
+	const auto maxSize = static_cast<size_t>(text.size()) / 4 * 3 + 3;
+	ensureCapacity(_cipher, maxSize);
+	size_t size = 0;
+	if(!decodeInto(text, reinterpret_cast<quint8*>(_cipher.data()), maxSize, size))
+		return {};
+	return QByteArray::fromRawData(_cipher.constData(), static_cast<int>(size));
+}
+
+bool ReceiveBuffers::decodeBase64(const QByteArray &text, quint8 *out, size_t size)
+{
+	size_t decodedSize = 0;
+	return decodeInto(text, out, size, decodedSize) && decodedSize == size;
+}
+
+SecureByteArray *ReceiveBuffers::plaintext(size_t size)
+{
+	// grows geometrically and keeps its size, so only new high water marks allocate
+	if(_plain.size() < size) {
+		const auto newSize = std::max(size, _plain.size() * 2);
+		if(!_plain.reallocate(newSize, SecureByteArray::State::Noaccess))
+			return nullptr;
+	}
+	_highWaterMark = std::max(_highWaterMark, size);
+	return &_plain;
+}
+
+void ReceiveBuffers::wipe(size_t size)
+{
+	Q_ASSERT(size <= _plain.size());
+	Q_ASSERT_X(_plain.state() == SecureByteArray::State::Readwrite, Q_FUNC_INFO, "The plaintext must be writable to be wiped");
+	sodium_memzero(_plain.data(), size);
+}
+
+void ReceiveBuffers::trim()
+{
+	// a single huge reply should not keep its buffers, especially not locked memory
+	if(static_cast<size_t>(_cipher.capacity()) > RetainLimit)
+		_cipher = QByteArray{};
+	if(_plain.size() > RetainLimit)
+		_plain.deallocate();
+}
+
+void ReceiveBuffers::clear()
+{
+	_cipher = QByteArray{};
+	_plain.deallocate();
+	_highWaterMark = 0;
+}
+
+size_t ReceiveBuffers::highWaterMark() const
+{
+	return _highWaterMark;
+}
+
+bool ReceiveBuffers::decodeInto(const QByteArray &text, quint8 *out, size_t maxSize, size_t &size)
+{
+	// the text is a view into the received frame, so it can be decoded without copying
+	return sodium_base642bin(out, maxSize,
+							 text.constData(), static_cast<size_t>(text.size()),
+							 nullptr, &size, nullptr,
+							 sodium_base64_VARIANT_ORIGINAL) == 0;
+}
+
+void ReceiveBuffers::ensureCapacity(QByteArray &buffer, size_t size)
+{
+	// a reserved capacity survives resizing, so the steady state does not allocate
+	Q_ASSERT(size <= static_cast<size_t>(std::numeric_limits<int>::max()));
+	const auto intSize = static_cast<int>(size);
+	if(buffer.capacity() < intSize)
+		buffer.reserve(std::max(intSize, buffer.capacity() * 2));
+	buffer.resize(intSize);
+}
@@ -0,0 +1,37 @@
+#ifndef KPXCCLIENT_RECEIVEBUFFERS_P_H
+#define KPXCCLIENT_RECEIVEBUFFERS_P_H
+
+#include <QtCore/QByteArray>
+
+#include "securebytearray.h"
+
+namespace KPXCClient {
+
+class ReceiveBuffers
+{
+public:
+	static constexpr size_t RetainLimit = 1024 * 1024;
+
+	QByteArray decodeBase64(const QByteArray &text);
+	bool decodeBase64(const QByteArray &text, quint8 *out, size_t size);
+
+	SecureByteArray *plaintext(size_t size);
+	void wipe(size_t size);
+
+	void trim();
+	void clear();
+
+	size_t highWaterMark() const;
+
+private:
+	QByteArray _cipher;
+	SecureByteArray _plain;
+	size_t _highWaterMark = 0;
+
+	bool decodeInto(const QByteArray &text, quint8 *out, size_t maxSize, size_t &size);
+	static void ensureCapacity(QByteArray &buffer, size_t size);
+};
+
+}
+
+#endif // KPXCCLIENT_RECEIVEBUFFERS_P_H
@@ -0,0 +1,71 @@
+#include "securearena_p.h"
+#include "securememory_p.h"
+#include <sodium/utils.h>
+using namespace KPXCClient;
+
+SecureArena *SecureArena::instance()
+{
+	// never destroyed, static SecureByteArrays may still return their slots during shutdown
+	static auto arena = new SecureArena{};
+	return arena;
+}
+
+bool SecureArena::isEnabled() const
+{
+	return _enabled;
+}
+
+void SecureArena::setEnabled(bool enabled)
+{
+	_enabled = enabled;
+}
+
+quint8 *SecureArena::allocate(size_t size)
+{
+	const auto index = classIndex(size);
+	if(index == -1)
+		return nullptr;
+
+	QMutexLocker _{&_mutex};
+	auto &sizeClass = _classes[static_cast<size_t>(index)];
+	if(sizeClass.freeSlots.isEmpty() && !grow(sizeClass))
+		return nullptr;
+	return sizeClass.freeSlots.takeLast();
+}
+
+void SecureArena::free(quint8 *data, size_t size)
+{
+	const auto index = classIndex(size);
+	Q_ASSERT(index != -1);
+	auto &sizeClass = _classes[static_cast<size_t>(index)];
+	sodium_memzero(data, sizeClass.slotSize);
+
+	QMutexLocker _{&_mutex};
+	sizeClass.freeSlots.append(data);
+}
+
+int SecureArena::classIndex(size_t size)
+{
+	if(size > MaxSlotSize)
+		return -1;
+	auto index = 0;
+	for(auto slotSize = MinSlotSize; slotSize < size; slotSize *= 2)
+		++index;
+	return index;
+}
+
+bool SecureArena::grow(SizeClass &sizeClass)
+{
+	// one guarded and locked region serves many small secrets
+	const auto chunk = SecureMemory::instance()->allocate(ChunkSize);
+	if(!chunk)
+		return false;
+	sodium_memzero(chunk, ChunkSize);
+	_chunks.append(chunk);
+
+	const auto slotCount = static_cast<int>(ChunkSize / sizeClass.slotSize);
+	sizeClass.freeSlots.reserve(sizeClass.freeSlots.size() + slotCount);
+	for(auto i = slotCount - 1; i >= 0; --i)
+		sizeClass.freeSlots.append(chunk + static_cast<size_t>(i) * sizeClass.slotSize);
+	return true;
+}
@@ -0,0 +1,49 @@
+#ifndef KPXCCLIENT_SECUREARENA_P_H
+#define KPXCCLIENT_SECUREARENA_P_H
+
+#include <array>
+#include <atomic>
+
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+
+namespace KPXCClient {
+
+class SecureArena
+{
+public:
+	static constexpr size_t MinSlotSize = 32;
+	static constexpr size_t MaxSlotSize = 256;
+	static constexpr size_t ChunkSize = 64 * 1024;
+
+	static SecureArena *instance();
+
+	bool isEnabled() const;
+	void setEnabled(bool enabled);
+
+	quint8 *allocate(size_t size);
+	void free(quint8 *data, size_t size);
+
+private:
+	struct SizeClass {
+		size_t slotSize;
+		QVector<quint8*> freeSlots;
+	};
+
+	std::atomic_bool _enabled{false};
+	QMutex _mutex;
+	std::array<SizeClass, 4> _classes {{
+		{MinSlotSize, {}},
+		{MinSlotSize * 2, {}},
+		{MinSlotSize * 4, {}},
+		{MaxSlotSize, {}}
+	}};
+	QVector<void*> _chunks;
+
+	static int classIndex(size_t size);
+	bool grow(SizeClass &sizeClass);
+};
+
+}
+
+#endif // KPXCCLIENT_SECUREARENA_P_H
@@ -1,12 +1,25 @@
 #include "securebytearray.h"
 #include "securebytearray_p.h"
+#include "securearena_p.h"
+#include "securememory_p.h"
+#include <QtCore/QDebug>
+#include <QtCore/QAbstractEventDispatcher>
+#include <QtCore/QTimer>
 #include <sodium/utils.h>
+#include <atomic>
 using namespace KPXCClient;
 
 #ifdef max
 #undef max
 #endif
 
+namespace {
+
+std::atomic<SecureByteArray::AccessMode> globalAccessMode{SecureByteArray::AccessMode::Batched};
+std::atomic<qint64> globalAccessIdleTimeout{0};
+
+}
+
 SecureByteArray::SecureByteArray() :
 	d{new SecureByteArrayData{}}
 {}
@@ -20,9 +33,10 @@ SecureByteArray::SecureByteArray(size_t size, SecureByteArray::State state) :
 SecureByteArray::SecureByteArray(const QByteArray &data, SecureByteArray::State state) :
 	SecureByteArray{}
 {
-	reallocate(data.size(), State::Readwrite);
-	memcpy(d->data, data.constData(), d->size);
-	setState(state);
+	if(reallocate(data.size(), State::Readwrite)) {
+		memcpy(d->data, data.constData(), d->size);
+		setState(state);
+	}
 }
 
 SecureByteArray::SecureByteArray(const SecureByteArray &other) = default;
@@ -129,9 +143,9 @@ quint8 *SecureByteArray::data()
 	return d->data;
 }
 
-void SecureByteArray::reallocate(size_t size, SecureByteArray::State state)
+bool SecureByteArray::reallocate(size_t size, SecureByteArray::State state)
 {
-	d->reallocate(size, state);
+	return d->reallocate(size, state);
 }
 
 void SecureByteArray::deallocate()
@@ -156,9 +170,57 @@ void SecureByteArray::add(const SecureByteArray &other, bool autoState)
 	sodium_add(d->data, other.d->data, d->size);
 }
 
+bool SecureByteArray::isArenaEnabled()
+{
+	return SecureArena::instance()->isEnabled();
+}
+
+void SecureByteArray::setArenaEnabled(bool enabled)
+{
+	SecureArena::instance()->setEnabled(enabled);
+}
+
+SecureByteArray::AccessMode SecureByteArray::accessMode()
+{
+	return globalAccessMode;
+}
+
+void SecureByteArray::setAccessMode(SecureByteArray::AccessMode mode)
+{
+	globalAccessMode = mode;
+}
+
+std::chrono::milliseconds SecureByteArray::accessIdleTimeout()
+{
+	return std::chrono::milliseconds{globalAccessIdleTimeout};
+}
+
+void SecureByteArray::setAccessIdleTimeout(std::chrono::milliseconds timeout)
+{
+	globalAccessIdleTimeout = timeout.count();
+}
+
+SecureByteArray::MemoryStatistics SecureByteArray::memoryStatistics()
+{
+	return SecureMemory::instance()->statistics();
+}
+
+quint64 SecureByteArray::lockedPageBudget()
+{
+	return SecureMemory::instance()->budget();
+}
+
+void SecureByteArray::setLockedPageBudget(quint64 pages)
+{
+	SecureMemory::instance()->setBudget(pages);
+}
+
 bool SecureByteArray::setState(SecureByteArray::State state)
 {
-	return d->setState(state);
+	const auto data = d.data();
+	data->undefer();
+	QMutexLocker _{&data->stateMutex};
+	return data->setState(state);
 }
 
 bool SecureByteArray::makeNoaccess()
@@ -176,15 +238,34 @@ bool SecureByteArray::makeReadwrite()
 	return setState(State::Readwrite);
 }
 
+SecureByteArray::State SecureByteArray::restingState() const
+{
+	const auto data = d.constData();
+	return data->epoch ? data->sealState : data->state;
+}
+
+void SecureByteArray::restoreState(SecureByteArray::State finalState)
+{
+	// only resealing is postponed, opening up further always happens right away
+	const auto epoch = SecureAccessEpoch::current();
+	if(accessMode() == AccessMode::Batched &&
+	   epoch->isActive() &&
+	   !isNull() &&
+	   finalState < state())
+		epoch->defer(d.data(), finalState);
+	else
+		setState(finalState);
+}
+
 
 
 SecureByteArray::StateLocker::StateLocker(SecureByteArray *data) :
 	_data{data},
-	_finalState{data->state()}
+	_finalState{data->restingState()}
 {}
 
 SecureByteArray::StateLocker::StateLocker(SecureByteArray *data, SecureByteArray::State newState) :
-	StateLocker{data, newState, data->state()}
+	StateLocker{data, newState, data->restingState()}
 {}
 
 SecureByteArray::StateLocker::StateLocker(SecureByteArray *data, SecureByteArray::State newState, SecureByteArray::State finalState):
@@ -197,7 +278,7 @@ SecureByteArray::StateLocker::StateLocker(SecureByteArray *data, SecureByteArray
 SecureByteArray::StateLocker::~StateLocker()
 {
 	if(_data)
-		_data->setState(_finalState);
+		_data->restoreState(_finalState);
 }
 
 void SecureByteArray::StateLocker::setFinalState(SecureByteArray::State finalState)
@@ -207,41 +288,106 @@ void SecureByteArray::StateLocker::setFinalState(SecureByteArray::State finalSta
 
 void SecureByteArray::StateLocker::unlock()
 {
-	_data->setState(_finalState);
+	_data->restoreState(_finalState);
 	_data = nullptr;
 }
 
 
 
+SecureByteArray::ReadLocker::ReadLocker(const SecureByteArray &data) :
+	_data{const_cast<SecureByteArrayData*>(data.d.constData())}
+{
+	// page protection is not part of the value, so readers neither detach nor need exclusive access
+	if(!_data->acquireRead())
+		_data = nullptr;
+}
+
+SecureByteArray::ReadLocker::~ReadLocker()
+{
+	unlock();
+}
+
+bool SecureByteArray::ReadLocker::isLocked() const
+{
+	return _data;
+}
+
+void SecureByteArray::ReadLocker::unlock()
+{
+	if(_data) {
+		_data->releaseRead();
+		_data = nullptr;
+	}
+}
+
+
+
+SecureByteArray::AccessEpoch::AccessEpoch()
+{
+	SecureAccessEpoch::current()->begin();
+}
+
+SecureByteArray::AccessEpoch::~AccessEpoch()
+{
+	SecureAccessEpoch::current()->end();
+}
+
+
+
 SecureByteArrayData::SecureByteArrayData(const SecureByteArrayData &other) :
 	QSharedData{other}
 {
-	reallocate(other.size, SecureByteArray::State::Readwrite);
-	memcpy(data, other.data, size);
-	setState(other.state);
+	if(reallocate(other.size, SecureByteArray::State::Readwrite)) {
+		memcpy(data, other.data, size);
+		setState(other.epoch ? other.sealState : other.state);
+	}
 }
 
 SecureByteArrayData::~SecureByteArrayData()
 {
+	Q_ASSERT_X(readers == 0, Q_FUNC_INFO, "SecureByteArray destroyed while a ReadLocker still uses it");
 	deallocate();
 }
 
-void SecureByteArrayData::reallocate(size_t size, SecureByteArray::State state)
+bool SecureByteArrayData::reallocate(size_t size, SecureByteArray::State state)
 {
 	deallocate();
 
-	data = reinterpret_cast<quint8*>(sodium_malloc(size));
-	Q_ASSERT(data);
+	// small secrets share locked pages of the arena, everything else gets its own guarded allocation
+	const auto arena = SecureArena::instance();
+	const auto memory = SecureMemory::instance();
+	data = arena->isEnabled() ? arena->allocate(size) : nullptr;
+	pooled = data != nullptr;
+	if(!pooled)
+		data = memory->allocate(size);
+	// over budget or out of lockable memory: the array stays unallocated
+	if(!data) {
+		memory->addFailure();
+		qWarning() << "Failed to allocate" << size
+				   << "bytes of secure memory with" << memory->statistics().pagesLocked
+				   << "pages locked and a budget of" << memory->budget() << "pages";
+		return false;
+	}
+	memory->addBuffer(size);
 	this->size = size;
 	this->state = SecureByteArray::State::Readwrite;
 	setState(state);
+	return true;
 }
 
 void SecureByteArrayData::deallocate()
 {
+	// waits for a reseal of another thread that still holds the data
+	undefer();
+	QMutexLocker _{&stateMutex};
 	if(data) {
-		sodium_free(data);
+		if(pooled)
+			SecureArena::instance()->free(data, size);
+		else
+			SecureMemory::instance()->free(data, size);
+		SecureMemory::instance()->removeBuffer(size);
 		data = nullptr;
+		pooled = false;
 		size = 0;
 		state = SecureByteArray::State::Unallocated;
 	}
@@ -258,6 +404,11 @@ bool SecureByteArrayData::setState(SecureByteArray::State newState)
 			   "Cannot set change memory state if no memory has been allocated yet!");
 	if(newState == state)
 		return true;
+	// page protection cannot be applied to a slot that shares its pages
+	if(pooled) {
+		state = newState;
+		return true;
+	}
 
 	auto ok = false;
 	switch (newState) {
@@ -274,12 +425,154 @@ bool SecureByteArrayData::setState(SecureByteArray::State newState)
 		Q_UNREACHABLE();
 		break;
 	}
+	SecureMemory::instance()->addProtect();
 
 	if(ok)
 		state = newState;
 	return ok;
 }
 
+bool SecureByteArrayData::acquireRead()
+{
+	// readers joining already opened pages only touch the counter
+	auto count = readers.load(std::memory_order_acquire);
+	while(count > 0) {
+		if(readers.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel))
+			return true;
+	}
+
+	QMutexLocker _{&stateMutex};
+	if(readers == 0) {
+		if(state == SecureByteArray::State::Unallocated)
+			return false;
+		const auto owner = epoch.load();
+		readSealState = owner ? sealState : state;
+		if(state < SecureByteArray::State::Readonly &&
+		   !setState(SecureByteArray::State::Readonly))
+			return false;
+	}
+	readers.fetch_add(1, std::memory_order_acq_rel);
+	return true;
+}
+
+void SecureByteArrayData::releaseRead()
+{
+	auto count = readers.load(std::memory_order_acquire);
+	while(count > 1) {
+		if(readers.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel))
+			return;
+	}
+
+	// the epoch is locked after the state mutex was released, resealing locks them the other way round
+	auto deferTo = SecureByteArray::State::Unallocated;
+	auto resealed = false;
+	{
+		QMutexLocker _{&stateMutex};
+		if(readers.fetch_sub(1, std::memory_order_acq_rel) != 1 ||
+		   readSealState >= state)
+			return;
+		if(SecureByteArray::accessMode() == SecureByteArray::AccessMode::Batched &&
+		   SecureAccessEpoch::current()->isActive())
+			deferTo = readSealState;
+		else
+			resealed = setState(readSealState);
+	}
+
+	if(deferTo != SecureByteArray::State::Unallocated)
+		SecureAccessEpoch::current()->defer(this, deferTo);
+	else if(resealed)
+		undefer();
+}
+
+void SecureByteArrayData::undefer()
+{
+	const auto owner = epoch.load();
+	if(owner)
+		owner->remove(this);
+}
+
+
+
+SecureAccessEpoch *SecureAccessEpoch::current()
+{
+	thread_local SecureAccessEpoch epoch;
+	return &epoch;
+}
+
+SecureAccessEpoch::~SecureAccessEpoch()
+{
+	reseal();
+}
+
+bool SecureAccessEpoch::isActive() const
+{
+	return _depth > 0;
+}
+
+void SecureAccessEpoch::begin()
+{
+	// cancels a pending idle reseal, data that is still open is reused as is
+	++_depth;
+	++_generation;
+}
+
+void SecureAccessEpoch::end()
+{
+	Q_ASSERT_X(_depth > 0, Q_FUNC_INFO, "AccessEpoch ended without being started");
+	if(--_depth > 0)
+		return;
+
+	const auto timeout = SecureByteArray::accessIdleTimeout();
+	if(timeout.count() <= 0 || !QAbstractEventDispatcher::instance())
+		reseal();
+	else {
+		const auto generation = _generation;
+		QTimer::singleShot(timeout, [this, generation]() {
+			if(_depth == 0 && _generation == generation)
+				reseal();
+		});
+	}
+}
+
+void SecureAccessEpoch::defer(SecureByteArrayData *data, SecureByteArray::State sealState)
+{
+	// data that was left open by another thread now belongs to this one
+	const auto owner = data->epoch.load();
+	if(owner && owner != this)
+		data->undefer();
+
+	QMutexLocker _{&_mutex};
+	// published after the seal state, so readers never combine the epoch with a stale one
+	data->sealState = sealState;
+	if(!data->epoch) {
+		data->epoch = this;
+		_deferred.append(data);
+	}
+}
+
+void SecureAccessEpoch::remove(SecureByteArrayData *data)
+{
+	QMutexLocker _{&_mutex};
+	if(data->epoch == this) {
+		_deferred.removeOne(data);
+		QMutexLocker dataLocker{&data->stateMutex};
+		data->epoch = nullptr;
+	}
+}
+
+void SecureAccessEpoch::reseal()
+{
+	QMutexLocker _{&_mutex};
+	for(const auto data : qAsConst(_deferred)) {
+		// cleared under the state mutex, so a deallocation that sees no epoch waits for the reseal
+		QMutexLocker dataLocker{&data->stateMutex};
+		data->epoch = nullptr;
+		if(data->readers == 0)
+			data->setState(data->sealState);
+	}
+	_deferred.clear();
+}
+
 uint KPXCClient::qHash(const SecureByteArray &key, uint seed)
 {
 	return qHash(key.asByteArray(), seed);
@@ -1,6 +1,8 @@
 #ifndef KPXCCLIENT_SECUREBYTEARRAY_H
 #define KPXCCLIENT_SECUREBYTEARRAY_H
 
+#include <chrono>
+
 #include <QtCore/QObject>
 #include <QtCore/QMetaObject>
 #include <QtCore/QByteArray>
@@ -25,6 +27,25 @@ public:
 	};
 	Q_ENUM(State)
 
+	enum class AccessMode {
+		Strict,
+		Batched
+	};
+	Q_ENUM(AccessMode)
+
+	struct KPXCCLIENT_EXPORT MemoryStatistics {
+		quint64 bytesRequested = 0;
+		quint64 peakBytesRequested = 0;
+		quint64 pagesLocked = 0;
+		quint64 peakPagesLocked = 0;
+		quint64 pageSize = 0;
+		quint64 allocationCount = 0;
+		quint64 totalAllocations = 0;
+		quint64 failedAllocations = 0;
+		quint64 mprotectCalls = 0;
+		quint64 lockedPageBudget = 0;
+	};
+
 	class KPXCCLIENT_EXPORT StateLocker {
 		Q_DISABLE_COPY(StateLocker)
 	public:
@@ -42,6 +63,26 @@ public:
 		State _finalState;
 	};
 
+	class KPXCCLIENT_EXPORT ReadLocker {
+		Q_DISABLE_COPY(ReadLocker)
+	public:
+		explicit ReadLocker(const SecureByteArray &data);
+		~ReadLocker();
+
+		bool isLocked() const;
+		void unlock();
+
+	private:
+		SecureByteArrayData *_data;
+	};
+
+	class KPXCCLIENT_EXPORT AccessEpoch {
+		Q_DISABLE_COPY(AccessEpoch)
+	public:
+		AccessEpoch();
+		~AccessEpoch();
+	};
+
 	SecureByteArray();
 	SecureByteArray(size_t size, State state = State::Readwrite);
 	SecureByteArray(const QByteArray &data, State state = State::Readwrite);
@@ -72,12 +113,24 @@ public:
 	const quint8 *data() const;
 	quint8 *data();
 
-	void reallocate(size_t size, State state = State::Readwrite);
+	bool reallocate(size_t size, State state = State::Readwrite);
 	void deallocate();
 
 	void increment(bool autoState = false);
 	void add(const SecureByteArray &other, bool autoState = false);
 
+	static bool isArenaEnabled();
+	static void setArenaEnabled(bool enabled);
+
+	static AccessMode accessMode();
+	static void setAccessMode(AccessMode mode);
+	static std::chrono::milliseconds accessIdleTimeout();
+	static void setAccessIdleTimeout(std::chrono::milliseconds timeout);
+
+	static MemoryStatistics memoryStatistics();
+	static quint64 lockedPageBudget();
+	static void setLockedPageBudget(quint64 pages);
+
 	bool setState(State state);
 	bool makeNoaccess();
 	bool makeReadonly();
@@ -85,6 +138,9 @@ public:
 
 private:
 	QSharedDataPointer<SecureByteArrayData> d;
+
+	State restingState() const;
+	void restoreState(State finalState);
 };
 
 KPXCCLIENT_EXPORT uint qHash(const SecureByteArray &key, uint seed);
@@ -3,22 +3,64 @@
 
 #include "securebytearray.h"
 
+#include <atomic>
+
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+
 namespace KPXCClient {
 
+class SecureAccessEpoch;
+
 class SecureByteArrayData : public QSharedData
 {
 public:
 	quint8 *data = nullptr;
 	size_t size = 0;
-	SecureByteArray::State state = SecureByteArray::State::Unallocated;
+	// written under stateMutex, but read without it
+	std::atomic<SecureByteArray::State> state{SecureByteArray::State::Unallocated};
+	bool pooled = false;
+	// set while the data stays open past its StateLocker until the epoch ends, cleared under stateMutex
+	std::atomic<SecureAccessEpoch*> epoch{nullptr};
+	std::atomic<SecureByteArray::State> sealState{SecureByteArray::State::Unallocated};
+	// shared readers of the same data, the first one opens the pages and the last one reseals them
+	std::atomic_int readers{0};
+	SecureByteArray::State readSealState = SecureByteArray::State::Unallocated;
+	QMutex stateMutex;
 
 	SecureByteArrayData() = default;
 	SecureByteArrayData(const SecureByteArrayData &other);
 	~SecureByteArrayData();
 
-	void reallocate(size_t size, SecureByteArray::State state);
+	bool reallocate(size_t size, SecureByteArray::State state);
 	void deallocate();
 	bool setState(SecureByteArray::State newState);
+	void undefer();
+
+	bool acquireRead();
+	void releaseRead();
+};
+
+class SecureAccessEpoch
+{
+public:
+	static SecureAccessEpoch *current();
+
+	~SecureAccessEpoch();
+
+	bool isActive() const;
+	void begin();
+	void end();
+
+	void defer(SecureByteArrayData *data, SecureByteArray::State sealState);
+	void remove(SecureByteArrayData *data);
+	void reseal();
+
+private:
+	int _depth = 0;
+	quint64 _generation = 0;
+	QMutex _mutex;
+	QVector<SecureByteArrayData*> _deferred;
 };
 
 }
@@ -0,0 +1,119 @@
+#include "securememory_p.h"
+#include <sodium/utils.h>
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#else
+#include <unistd.h>
+#endif
+using namespace KPXCClient;
+
+SecureMemory *SecureMemory::instance()
+{
+	// never destroyed, like the arena that reports to it
+	static auto memory = new SecureMemory{};
+	return memory;
+}
+
+size_t SecureMemory::pageSize()
+{
+	static const auto size = []() -> size_t {
+#ifdef Q_OS_WIN
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+#else
+		const auto size = sysconf(_SC_PAGESIZE);
+		return size > 0 ? static_cast<size_t>(size) : 4096;
+#endif
+	}();
+	return size;
+}
+
+quint64 SecureMemory::lockedPages(size_t size)
+{
+	// sodium_malloc locks the pages holding the canary and the data, the guard pages are not locked
+	constexpr size_t CanarySize = 16;
+	const auto page = pageSize();
+	return (size + CanarySize + page - 1) / page;
+}
+
+quint64 SecureMemory::budget() const
+{
+	return _budget;
+}
+
+void SecureMemory::setBudget(quint64 pages)
+{
+	_budget = pages;
+}
+
+quint8 *SecureMemory::allocate(size_t size)
+{
+	// reserve the pages first, so concurrent allocations cannot overshoot the budget together
+	const auto pages = lockedPages(size);
+	const auto budget = _budget.load();
+	const auto current = _pages.fetch_add(pages) + pages;
+	if(budget != 0 && current > budget) {
+		_pages.fetch_sub(pages);
+		return nullptr;
+	}
+
+	const auto data = reinterpret_cast<quint8*>(sodium_malloc(size));
+	if(!data) {
+		_pages.fetch_sub(pages);
+		return nullptr;
+	}
+	raisePeak(_peakPages, current);
+	return data;
+}
+
+void SecureMemory::free(quint8 *data, size_t size)
+{
+	sodium_free(data);
+	_pages.fetch_sub(lockedPages(size));
+}
+
+void SecureMemory::addBuffer(size_t size)
+{
+	++_buffers;
+	++_totalBuffers;
+	raisePeak(_peakBytes, _bytes.fetch_add(size) + size);
+}
+
+void SecureMemory::removeBuffer(size_t size)
+{
+	--_buffers;
+	_bytes.fetch_sub(size);
+}
+
+void SecureMemory::addFailure()
+{
+	++_failures;
+}
+
+void SecureMemory::addProtect()
+{
+	_protects.fetch_add(1, std::memory_order_relaxed);
+}
+
+SecureByteArray::MemoryStatistics SecureMemory::statistics() const
+{
+	SecureByteArray::MemoryStatistics statistics;
+	statistics.bytesRequested = _bytes;
+	statistics.peakBytesRequested = _peakBytes;
+	statistics.pagesLocked = _pages;
+	statistics.peakPagesLocked = _peakPages;
+	statistics.pageSize = pageSize();
+	statistics.allocationCount = _buffers;
+	statistics.totalAllocations = _totalBuffers;
+	statistics.failedAllocations = _failures;
+	statistics.mprotectCalls = _protects;
+	statistics.lockedPageBudget = _budget;
+	return statistics;
+}
+
+void SecureMemory::raisePeak(std::atomic<quint64> &peak, quint64 value)
+{
+	auto current = peak.load();
+	while(current < value && !peak.compare_exchange_weak(current, value));
+}
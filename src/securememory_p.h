@@ -0,0 +1,49 @@
+#ifndef KPXCCLIENT_SECUREMEMORY_P_H
+#define KPXCCLIENT_SECUREMEMORY_P_H
+
+#include <atomic>
+
+#include <QtCore/QtGlobal>
+
+#include "securebytearray.h"
+
+namespace KPXCClient {
+
+class SecureMemory
+{
+public:
+	static SecureMemory *instance();
+
+	static size_t pageSize();
+	static quint64 lockedPages(size_t size);
+
+	quint64 budget() const;
+	void setBudget(quint64 pages);
+
+	quint8 *allocate(size_t size);
+	void free(quint8 *data, size_t size);
+
+	void addBuffer(size_t size);
+	void removeBuffer(size_t size);
+	void addFailure();
+	void addProtect();
+
+	SecureByteArray::MemoryStatistics statistics() const;
+
+private:
+	std::atomic<quint64> _budget{0};
+	std::atomic<quint64> _bytes{0};
+	std::atomic<quint64> _peakBytes{0};
+	std::atomic<quint64> _pages{0};
+	std::atomic<quint64> _peakPages{0};
+	std::atomic<quint64> _buffers{0};
+	std::atomic<quint64> _totalBuffers{0};
+	std::atomic<quint64> _failures{0};
+	std::atomic<quint64> _protects{0};
+
+	static void raisePeak(std::atomic<quint64> &peak, quint64 value);
+};
+
+}
+
+#endif // KPXCCLIENT_SECUREMEMORY_P_H
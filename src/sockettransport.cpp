@@ -0,0 +1,103 @@
+#include "sockettransport_p.h"
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStandardPaths>
+using namespace KPXCClient;
+
+SocketTransport::SocketTransport(const QString &serverName, QObject *parent) :
+	Transport{parent},
+	_socket{new QLocalSocket{this}},
+	_serverName{serverName}
+{
+	connect(_socket, &QLocalSocket::connected,
+			this, [this]() {
+		_opened = true;
+		emit started();
+	});
+	connect(_socket, &QLocalSocket::disconnected,
+			this, &SocketTransport::finished);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+	connect(_socket, &QLocalSocket::errorOccurred,
+			this, &SocketTransport::socketError);
+#else
+	connect(_socket, QOverload<QLocalSocket::LocalSocketError>::of(&QLocalSocket::error),
+			this, &SocketTransport::socketError);
+#endif
+	connect(_socket, &QLocalSocket::readyRead,
+			this, &SocketTransport::readyRead);
+	connect(_socket, &QLocalSocket::bytesWritten,
+			this, &SocketTransport::bytesWritten);
+}
+
+QString SocketTransport::defaultServerName()
+{
+	// same lookup as keepassxc-proxy: runtime dir, flatpak location, then the pre 2.6 name
+	const auto runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+	const QDir dir{runtimeDir.isEmpty() ? QDir::tempPath() : runtimeDir};
+	const auto serverName = dir.absoluteFilePath(QStringLiteral("org.keepassxc.KeePassXC.BrowserServer"));
+	const auto flatpakName = dir.absoluteFilePath(QStringLiteral("app/org.keepassxc.KeePassXC/org.keepassxc.KeePassXC.BrowserServer"));
+	if(QFileInfo::exists(serverName))
+		return serverName;
+	else if(QFileInfo::exists(flatpakName))
+		return flatpakName;
+	else if(QFileInfo::exists(dir.absoluteFilePath(QStringLiteral("kpxc_server"))))
+		return dir.absoluteFilePath(QStringLiteral("kpxc_server"));
+	else
+		return serverName;
+}
+
+void SocketTransport::open()
+{
+	_socket->connectToServer(_serverName);
+}
+
+void SocketTransport::closeWriteChannel()
+{
+	// waits for pending data to be written
+	_socket->disconnectFromServer();
+}
+
+void SocketTransport::terminate()
+{
+	_socket->abort();
+}
+
+void SocketTransport::kill()
+{
+	_socket->abort();
+}
+
+bool SocketTransport::isLengthPrefixed() const
+{
+	// KeePassXC reads plain JSON documents from the socket
+	return false;
+}
+
+qint64 SocketTransport::bytesToWrite() const
+{
+	return _socket->bytesToWrite();
+}
+
+void SocketTransport::write(FrameQueue &queue)
+{
+	_socket->write(queue.gather());
+}
+
+FrameDecoder::Result SocketTransport::readFrame(QByteArray &frame)
+{
+	const auto available = _socket->bytesAvailable();
+	if(available > 0) {
+		const auto bytesRead = _socket->read(_decoder.reserve(available), available);
+		_decoder.commit(qMax<qint64>(bytesRead, 0));
+	}
+	return _decoder.nextFrame(frame);
+}
+
+void SocketTransport::socketError(QLocalSocket::LocalSocketError error)
+{
+	qCritical() << error << _socket->errorString();
+	// a socket that never connected will not report disconnected
+	if(!_opened)
+		emit failed(_socket->errorString());
+}
@@ -0,0 +1,42 @@
+#ifndef KPXCCLIENT_SOCKETTRANSPORT_P_H
+#define KPXCCLIENT_SOCKETTRANSPORT_P_H
+
+#include <QtNetwork/QLocalSocket>
+
+#include "transport_p.h"
+#include "jsonstreamdecoder_p.h"
+
+namespace KPXCClient {
+
+class SocketTransport : public Transport
+{
+	Q_OBJECT
+
+public:
+	explicit SocketTransport(const QString &serverName, QObject *parent = nullptr);
+
+	static QString defaultServerName();
+
+	void open() override;
+	void closeWriteChannel() override;
+	void terminate() override;
+	void kill() override;
+
+	bool isLengthPrefixed() const override;
+	qint64 bytesToWrite() const override;
+	void write(FrameQueue &queue) override;
+	FrameDecoder::Result readFrame(QByteArray &frame) override;
+
+private Q_SLOTS:
+	void socketError(QLocalSocket::LocalSocketError error);
+
+private:
+	QLocalSocket *_socket;
+	QString _serverName;
+	JsonStreamDecoder _decoder;
+	bool _opened = false;
+};
+
+}
+
+#endif // KPXCCLIENT_SOCKETTRANSPORT_P_H
@@ -1,4 +1,5 @@
 #include "sodiumcryptor_p.h"
+#include <QtCore/QDebug>
 #include <sodium/crypto_box.h>
 #include <sodium/utils.h>
 #include <sodium/randombytes.h>
@@ -8,11 +9,25 @@ SodiumCryptor::SodiumCryptor(QObject *parent) :
 	QObject{parent}
 {}
 
+SodiumCryptor::~SodiumCryptor() = default;
+
+bool SodiumCryptor::isBufferedRandom() const
+{
+	return _bufferedRandom;
+}
+
+void SodiumCryptor::setBufferedRandom(bool bufferedRandom)
+{
+	// may be called from another thread, the pool itself is only touched by the cryptors thread
+	_bufferedRandom = bufferedRandom;
+}
+
 SecureByteArray SodiumCryptor::generateRandom(size_t bytes, SecureByteArray::State state) const
 {
 	SecureByteArray data;
-	data.reallocate(bytes);
-	randombytes(data.data(), data.size());
+	if(!data.reallocate(bytes))
+		return data;
+	randomBytes(data.data(), data.size());
 	data.setState(state);
 	return data;
 }
@@ -24,9 +39,14 @@ SecureByteArray SodiumCryptor::generateRandomNonce(SecureByteArray::State state)
 
 bool SodiumCryptor::createKeys()
 {
-	_secretKey.reallocate(crypto_box_SECRETKEYBYTES);
-	_publicKey.reallocate(crypto_box_PUBLICKEYBYTES);
-	const auto ok = crypto_box_keypair(_publicKey.data(), _secretKey.data()) == 0;
+	if(!_secretKey.reallocate(crypto_box_SECRETKEYBYTES) ||
+	   !_publicKey.reallocate(crypto_box_PUBLICKEYBYTES))
+		return false;
+	SecureByteArray seed{crypto_box_SEEDBYTES};
+	if(seed.isNull())
+		return false;
+	randomBytes(seed.data(), seed.size());
+	const auto ok = crypto_box_seed_keypair(_publicKey.data(), _secretKey.data(), seed.constData()) == 0;
 	_secretKey.makeNoaccess();
 	_publicKey.makeReadonly();
 	return ok;
@@ -36,6 +56,8 @@ void SodiumCryptor::dropKeys()
 {
 	_secretKey.deallocate();
 	_publicKey.deallocate();
+	_sharedKey.deallocate();
+	_randomPool.reset();
 }
 
 SecureByteArray SodiumCryptor::publicKey() const
@@ -43,11 +65,48 @@ SecureByteArray SodiumCryptor::publicKey() const
 	return _publicKey;
 }
 
+void SodiumCryptor::randomBytes(quint8 *out, size_t size) const
+{
+	if(_bufferedRandom) {
+		if(!_randomPool) {
+			_randomPool.reset(new RandomPool{});
+			// the locked page budget may refuse the pool, it then serves from randombytes_buf
+			if(!_randomPool->isValid())
+				qWarning() << "Secure memory budget exhausted, buffered random bytes are disabled";
+		}
+		_randomPool->fill(out, size);
+	} else {
+		_randomPool.reset();
+		randombytes_buf(out, size);
+	}
+}
+
+bool SodiumCryptor::precompute(const SecureByteArray &publicKey)
+{
+	// the scalar multiplication only depends on the key pairs, so it is done once per session
+	if(!_sharedKey.reallocate(crypto_box_BEFORENMBYTES))
+		return false;
+	SecureByteArray::ReadLocker _{_secretKey};
+	const auto ok = crypto_box_beforenm(_sharedKey.data(),
+										publicKey.constData(),
+										_secretKey.constData()) == 0;
+	if(ok)
+		_sharedKey.makeNoaccess();
+	else
+		_sharedKey.deallocate();
+	return ok;
+}
+
+bool SodiumCryptor::hasSharedKey() const
+{
+	return !_sharedKey.isNull();
+}
+
 QByteArray SodiumCryptor::encrypt(const QByteArray &plain, const SecureByteArray &publicKey, const SecureByteArray &nonce)
 {
 	QByteArray cipher{static_cast<int>(plain.size() + crypto_box_MACBYTES), Qt::Uninitialized};
 
-	SecureByteArray::StateLocker _{&_secretKey, SecureByteArray::State::Readonly};
+	SecureByteArray::ReadLocker _{_secretKey};
 	const auto ok = crypto_box_easy(reinterpret_cast<quint8*>(cipher.data()),
 									reinterpret_cast<const quint8*>(plain.constData()),
 									plain.size(),
@@ -65,7 +124,7 @@ QByteArray SodiumCryptor::decrypt(const QByteArray &cipher, const SecureByteArra
 
 	QByteArray plain{static_cast<int>(cipher.size() - crypto_box_MACBYTES), Qt::Uninitialized};
 
-	SecureByteArray::StateLocker _{&_secretKey, SecureByteArray::State::Readonly};
+	SecureByteArray::ReadLocker _{_secretKey};
 	const auto ok = crypto_box_open_easy(reinterpret_cast<quint8*>(plain.data()),
 										 reinterpret_cast<const quint8*>(cipher.constData()),
 										 cipher.size(),
@@ -75,3 +134,58 @@ QByteArray SodiumCryptor::decrypt(const QByteArray &cipher, const SecureByteArra
 
 	return ok ? plain : QByteArray{};
 }
+
+QByteArray SodiumCryptor::encrypt(const QByteArray &plain, const quint8 *nonce)
+{
+	Q_ASSERT_X(hasSharedKey(), Q_FUNC_INFO, "precompute must be called before encrypting with the shared key");
+	if(!hasSharedKey())
+		return {};
+	QByteArray cipher{static_cast<int>(plain.size() + crypto_box_MACBYTES), Qt::Uninitialized};
+
+	SecureByteArray::ReadLocker _{_sharedKey};
+	const auto ok = crypto_box_easy_afternm(reinterpret_cast<quint8*>(cipher.data()),
+											reinterpret_cast<const quint8*>(plain.constData()),
+											plain.size(),
+											nonce,
+											_sharedKey.constData()) == 0;
+
+	return ok ? cipher : QByteArray{};
+}
+
+bool SodiumCryptor::encryptInPlace(quint8 *data, size_t plainSize, const quint8 *nonce)
+{
+	// data must have room for crypto_box_MACBYTES more, the MAC is placed before the ciphertext
+	Q_ASSERT_X(hasSharedKey(), Q_FUNC_INFO, "precompute must be called before encrypting with the shared key");
+	if(!hasSharedKey())
+		return false;
+	SecureByteArray::ReadLocker _{_sharedKey};
+	return crypto_box_easy_afternm(data, data, plainSize, nonce, _sharedKey.constData()) == 0;
+}
+
+bool SodiumCryptor::decryptInto(quint8 *plain, const quint8 *cipher, size_t cipherSize, const quint8 *nonce)
+{
+	// plain must have room for cipherSize - crypto_box_MACBYTES bytes
+	Q_ASSERT_X(hasSharedKey(), Q_FUNC_INFO, "precompute must be called before decrypting with the shared key");
+	if(!hasSharedKey() || cipherSize < crypto_box_MACBYTES)
+		return false;
+	SecureByteArray::ReadLocker _{_sharedKey};
+	return crypto_box_open_easy_afternm(plain, cipher, cipherSize, nonce, _sharedKey.constData()) == 0;
+}
+
+QByteArray SodiumCryptor::decrypt(const QByteArray &cipher, const quint8 *nonce)
+{
+	Q_ASSERT_X(hasSharedKey(), Q_FUNC_INFO, "precompute must be called before decrypting with the shared key");
+	if(!hasSharedKey() || cipher.size() < static_cast<int>(crypto_box_MACBYTES))
+		return {};
+
+	QByteArray plain{static_cast<int>(cipher.size() - crypto_box_MACBYTES), Qt::Uninitialized};
+
+	SecureByteArray::ReadLocker _{_sharedKey};
+	const auto ok = crypto_box_open_easy_afternm(reinterpret_cast<quint8*>(plain.data()),
+												 reinterpret_cast<const quint8*>(cipher.constData()),
+												 cipher.size(),
+												 nonce,
+												 _sharedKey.constData()) == 0;
+
+	return ok ? plain : QByteArray{};
+}
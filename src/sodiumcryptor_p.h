@@ -1,12 +1,15 @@
 #ifndef KPXCCLIENT_SODIUMCRYPTOR_P_H
 #define KPXCCLIENT_SODIUMCRYPTOR_P_H
 
+#include <atomic>
 #include <tuple>
 
 #include <QtCore/QObject>
 #include <QtCore/QByteArray>
+#include <QtCore/QScopedPointer>
 
 #include "securebytearray.h"
+#include "randompool_p.h"
 
 namespace KPXCClient {
 
@@ -16,6 +19,10 @@ class SodiumCryptor : public QObject
 
 public:
 	explicit SodiumCryptor(QObject *parent = nullptr);
+	~SodiumCryptor() override;
+
+	bool isBufferedRandom() const;
+	void setBufferedRandom(bool bufferedRandom);
 
 	SecureByteArray generateRandom(size_t bytes, SecureByteArray::State state = SecureByteArray::State::Readwrite) const;
 	SecureByteArray generateRandomNonce(SecureByteArray::State state = SecureByteArray::State::Readwrite) const;
@@ -24,6 +31,9 @@ public:
 	void dropKeys();
 	SecureByteArray publicKey() const;
 
+	bool precompute(const SecureByteArray &publicKey);
+	bool hasSharedKey() const;
+
 	QByteArray encrypt(const QByteArray &plain,
 					   const SecureByteArray &publicKey,
 					   const SecureByteArray &nonce);
@@ -31,9 +41,19 @@ public:
 					   const SecureByteArray &publicKey,
 					   const SecureByteArray &nonce);
 
+	QByteArray encrypt(const QByteArray &plain, const quint8 *nonce);
+	QByteArray decrypt(const QByteArray &cipher, const quint8 *nonce);
+	bool encryptInPlace(quint8 *data, size_t plainSize, const quint8 *nonce);
+	bool decryptInto(quint8 *plain, const quint8 *cipher, size_t cipherSize, const quint8 *nonce);
+
 private:
 	SecureByteArray _secretKey;
 	SecureByteArray _publicKey;
+	SecureByteArray _sharedKey;
+	std::atomic_bool _bufferedRandom{false};
+	mutable QScopedPointer<RandomPool> _randomPool;
+
+	void randomBytes(quint8 *out, size_t size) const;
 };
 
 }
@@ -0,0 +1,73 @@
+#ifndef KPXCCLIENT_SPSCQUEUE_P_H
+#define KPXCCLIENT_SPSCQUEUE_P_H
+
+#include <atomic>
+
+#include <QtCore/qglobal.h>
+
+namespace KPXCClient {
+
+template <typename T>
+class SpscQueue
+{
+	Q_DISABLE_COPY(SpscQueue)
+
+public:
+	SpscQueue();
+	~SpscQueue();
+
+	void enqueue(T value);
+	bool dequeue(T &value);
+
+private:
+	struct Node {
+		T value;
+		std::atomic<Node*> next{nullptr};
+	};
+
+	// producer and consumer side on separate cache lines
+	alignas(64) Node *_last;
+	alignas(64) Node *_first;
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue() :
+	_last{new Node{}},
+	_first{_last}
+{}
+
+template <typename T>
+SpscQueue<T>::~SpscQueue()
+{
+	while(_first) {
+		const auto next = _first->next.load(std::memory_order_relaxed);
+		delete _first;
+		_first = next;
+	}
+}
+
+template <typename T>
+void SpscQueue<T>::enqueue(T value)
+{
+	const auto node = new Node{std::move(value)};
+	_last->next.store(node, std::memory_order_release);
+	_last = node;
+}
+
+template <typename T>
+bool SpscQueue<T>::dequeue(T &value)
+{
+	// _first is always a consumed dummy node, the value lives in its successor
+	const auto next = _first->next.load(std::memory_order_acquire);
+	if(!next)
+		return false;
+
+	value = std::move(next->value);
+	delete _first;
+	_first = next;
+	return true;
+}
+
+}
+
+#endif // KPXCCLIENT_SPSCQUEUE_P_H
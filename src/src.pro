@@ -1,6 +1,6 @@
 TEMPLATE = lib
 
-QT = core
+QT = core network
 
 CONFIG += lib_bundle
 DEFINES += KPXCCLIENT_LIBRARY
@@ -15,7 +15,11 @@ PUBLIC_HEADERS += \
 	entry.h \
 	client.h \
 	idatabaseregistry.h \
-	defaultdatabaseregistry.h
+	defaultdatabaseregistry.h \
+	clientexception.h \
+	awaitable.h \
+	connectionpool.h \
+	loopbackserver.h
 
 PRIVATE_HEADERS += \
 	sodiumcryptor_p.h \
@@ -23,7 +27,29 @@ PRIVATE_HEADERS += \
 	client_p.h \
 	connector_p.h \
 	defaultdatabaseregistry_p.h \
-	entry_p.h
+	entry_p.h \
+	connectionpool_p.h \
+	framedecoder_p.h \
+	framequeue_p.h \
+	spscqueue_p.h \
+	connectorthread_p.h \
+	transport_p.h \
+	processtransport_p.h \
+	sockettransport_p.h \
+	jsonstreamdecoder_p.h \
+	loopbacktransport_p.h \
+	noncewindow_p.h \
+	randompool_p.h \
+	securearena_p.h \
+	securememory_p.h \
+	envelopeencoder_p.h \
+	receivebuffers_p.h \
+	jsonwriter_p.h \
+	jsonreader_p.h \
+	envelopedecoder_p.h \
+	protocol_p.h \
+	logincache_p.h \
+	negativecache_p.h
 
 HEADERS += $$PUBLIC_HEADERS $$PRIVATE_HEADERS
 
@@ -33,7 +59,29 @@ SOURCES += \
 	connector.cpp \
 	client.cpp \
 	defaultdatabaseregistry.cpp \
-	entry.cpp
+	entry.cpp \
+	clientexception.cpp \
+	connectionpool.cpp \
+	framedecoder.cpp \
+	framequeue.cpp \
+	connectorthread.cpp \
+	transport.cpp \
+	processtransport.cpp \
+	sockettransport.cpp \
+	jsonstreamdecoder.cpp \
+	loopbacktransport.cpp \
+	noncewindow.cpp \
+	randompool.cpp \
+	securearena.cpp \
+	securememory.cpp \
+	envelopeencoder.cpp \
+	receivebuffers.cpp \
+	jsonwriter.cpp \
+	jsonreader.cpp \
+	envelopedecoder.cpp \
+	protocol.cpp \
+	logincache.cpp \
+	negativecache.cpp
 
 unix {
 	CONFIG += link_pkgconfig
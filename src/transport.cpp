@@ -0,0 +1,11 @@
+#include "transport_p.h"
+using namespace KPXCClient;
+
+Transport::Transport(QObject *parent) :
+	QObject{parent}
+{}
+
+bool Transport::isLengthPrefixed() const
+{
+	return true;
+}
@@ -0,0 +1,40 @@
+#ifndef KPXCCLIENT_TRANSPORT_P_H
+#define KPXCCLIENT_TRANSPORT_P_H
+
+#include <QtCore/QObject>
+#include <QtCore/QByteArray>
+
+#include "framedecoder_p.h"
+#include "framequeue_p.h"
+
+namespace KPXCClient {
+
+class Transport : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit Transport(QObject *parent = nullptr);
+
+	virtual void open() = 0;
+	virtual void closeWriteChannel() = 0;
+	virtual void terminate() = 0;
+	virtual void kill() = 0;
+
+	virtual bool isLengthPrefixed() const;
+	virtual qint64 bytesToWrite() const = 0;
+	virtual void write(FrameQueue &queue) = 0;
+	virtual FrameDecoder::Result readFrame(QByteArray &frame) = 0;
+
+Q_SIGNALS:
+	void started();
+	void finished();
+	void failed(const QString &errorString);
+
+	void readyRead();
+	void bytesWritten();
+};
+
+}
+
+#endif // KPXCCLIENT_TRANSPORT_P_H
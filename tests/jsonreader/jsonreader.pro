@@ -0,0 +1,8 @@
+TEMPLATE = app
+
+TARGET = tst_jsonreader
+
+include(../tests.pri)
+
+SOURCES += \
+	tst_jsonreader.cpp
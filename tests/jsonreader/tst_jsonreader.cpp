@@ -0,0 +1,205 @@
+#include <QtTest>
+
+#include <jsonreader_p.h>
+
+using namespace KPXCClient;
+
+class JsonReaderTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void testObject();
+	void testStrings_data();
+	void testStrings();
+	void testSkipNested();
+	void testDepthLimit_data();
+	void testDepthLimit();
+	void testInvalid_data();
+	void testInvalid();
+	void testInvalidStrings_data();
+	void testInvalidStrings();
+
+private:
+	static QByteArray nested(int depth);
+};
+
+void JsonReaderTest::testObject()
+{
+	const QByteArray json{" { \"s\" : \"text\", \"t\":true,\"f\":false,\"n\":-12.5e1,\"z\":null } "};
+	JsonReader reader{json};
+	QVERIFY(reader.beginObject());
+
+	QByteArray key;
+	QByteArray text;
+	auto flag = false;
+	auto number = 0.0;
+	QVERIFY(reader.nextKey(key));
+	QCOMPARE(key, QByteArray{"s"});
+	QCOMPARE(reader.peek(), JsonReader::Type::String);
+	QVERIFY(reader.readString(text));
+	QCOMPARE(text, QByteArray{"text"});
+	QVERIFY(reader.nextKey(key));
+	QCOMPARE(key, QByteArray{"t"});
+	QVERIFY(reader.readBool(flag));
+	QCOMPARE(flag, true);
+	QVERIFY(reader.nextKey(key));
+	QCOMPARE(key, QByteArray{"f"});
+	QVERIFY(reader.readBool(flag));
+	QCOMPARE(flag, false);
+	QVERIFY(reader.nextKey(key));
+	QCOMPARE(key, QByteArray{"n"});
+	QCOMPARE(reader.peek(), JsonReader::Type::Number);
+	QVERIFY(reader.readNumber(number));
+	QCOMPARE(number, -125.0);
+	QVERIFY(reader.nextKey(key));
+	QCOMPARE(key, QByteArray{"z"});
+	QCOMPARE(reader.peek(), JsonReader::Type::Null);
+	QVERIFY(reader.skipValue());
+
+	QVERIFY(!reader.nextKey(key));
+	QVERIFY(!reader.hasError());
+	QVERIFY(reader.atEnd());
+}
+
+void JsonReaderTest::testStrings_data()
+{
+	QTest::addColumn<QByteArray>("json");
+	QTest::addColumn<QByteArray>("result");
+
+	QTest::newRow("plain") << QByteArray{"\"abc\""}
+						   << QByteArray{"abc"};
+	QTest::newRow("empty") << QByteArray{"\"\""}
+						   << QByteArray{};
+	QTest::newRow("escapes") << QByteArray{"\"a\\\"\\\\\\/\\b\\f\\n\\r\\tz\""}
+							 << QByteArray{"a\"\\/\b\f\n\r\tz"};
+	QTest::newRow("utf8") << QByteArray{"\"\xc3\xa9\""}
+						  << QByteArray{"\xc3\xa9"};
+	QTest::newRow("unicode") << QByteArray{"\"\\u00e9\\u20AC\""}
+							 << QByteArray{"\xc3\xa9\xe2\x82\xac"};
+	QTest::newRow("surrogatePair") << QByteArray{"\"\\ud83d\\ude00\""}
+								   << QByteArray{"\xf0\x9f\x98\x80"};
+	QTest::newRow("loneHigh") << QByteArray{"\"\\ud83dz\""}
+							  << QByteArray{"\xef\xbf\xbd" "z"};
+	QTest::newRow("loneLow") << QByteArray{"\"\\ude00\""}
+							 << QByteArray{"\xef\xbf\xbd"};
+	QTest::newRow("highBeforeOther") << QByteArray{"\"\\ud83d\\u0041\""}
+									 << QByteArray{"\xef\xbf\xbd" "A"};
+}
+
+void JsonReaderTest::testStrings()
+{
+	QFETCH(QByteArray, json);
+	QFETCH(QByteArray, result);
+
+	JsonReader reader{json};
+	QByteArray value;
+	QVERIFY(reader.readString(value));
+	QCOMPARE(value, result);
+	QVERIFY(!reader.hasError());
+	QVERIFY(reader.atEnd());
+}
+
+void JsonReaderTest::testSkipNested()
+{
+	const QByteArray json{"{\"a\":{\"b\":[1,[],{},\"}]\",{\"c\":[true,null]}]},\"d\":\"e\"}"};
+	JsonReader reader{json};
+	QVERIFY(reader.beginObject());
+
+	QByteArray key;
+	QVERIFY(reader.nextKey(key));
+	QCOMPARE(key, QByteArray{"a"});
+	QCOMPARE(reader.peek(), JsonReader::Type::Object);
+	QVERIFY(reader.skipValue());
+
+	// the members after a skipped object are still read in order
+	QByteArray value;
+	QVERIFY(reader.nextKey(key));
+	QCOMPARE(key, QByteArray{"d"});
+	QVERIFY(reader.readString(value));
+	QCOMPARE(value, QByteArray{"e"});
+	QVERIFY(!reader.nextKey(key));
+	QVERIFY(!reader.hasError());
+}
+
+void JsonReaderTest::testDepthLimit_data()
+{
+	QTest::addColumn<int>("depth");
+	QTest::addColumn<bool>("valid");
+
+	QTest::newRow("limit") << JsonReader::MaxDepth << true;
+	QTest::newRow("exceeded") << JsonReader::MaxDepth + 1 << false;
+	QTest::newRow("deep") << 100000 << false;
+}
+
+void JsonReaderTest::testDepthLimit()
+{
+	QFETCH(int, depth);
+	QFETCH(bool, valid);
+
+	const auto json = nested(depth);
+	JsonReader reader{json};
+	QCOMPARE(reader.skipValue(), valid);
+	QCOMPARE(reader.hasError(), !valid);
+}
+
+void JsonReaderTest::testInvalid_data()
+{
+	QTest::addColumn<QByteArray>("json");
+
+	QTest::newRow("empty") << QByteArray{};
+	QTest::newRow("truncatedObject") << QByteArray{"{\"a\":"};
+	QTest::newRow("truncatedArray") << QByteArray{"[1,2"};
+	QTest::newRow("truncatedString") << QByteArray{"\"abc"};
+	QTest::newRow("missingColon") << QByteArray{"{\"a\" 1}"};
+	QTest::newRow("missingComma") << QByteArray{"[1 2]"};
+	QTest::newRow("invalidLiteral") << QByteArray{"[tru]"};
+}
+
+void JsonReaderTest::testInvalid()
+{
+	QFETCH(QByteArray, json);
+
+	JsonReader reader{json};
+	QVERIFY(!reader.skipValue());
+	QVERIFY(reader.hasError());
+}
+
+void JsonReaderTest::testInvalidStrings_data()
+{
+	QTest::addColumn<QByteArray>("json");
+
+	QTest::newRow("unquoted") << QByteArray{"abc"};
+	QTest::newRow("truncated") << QByteArray{"\"a\\n"};
+	QTest::newRow("truncatedEscape") << QByteArray{"\"\\u12\""};
+	QTest::newRow("invalidEscape") << QByteArray{"\"\\q\""};
+	QTest::newRow("invalidHex") << QByteArray{"\"\\u12g4\""};
+	QTest::newRow("invalidLowHex") << QByteArray{"\"\\ud83d\\uzzzz\""};
+}
+
+void JsonReaderTest::testInvalidStrings()
+{
+	QFETCH(QByteArray, json);
+
+	// skipped strings are not decoded, so escapes are only checked when reading
+	JsonReader reader{json};
+	QByteArray value;
+	QVERIFY(!reader.readString(value));
+	QVERIFY(reader.hasError());
+}
+
+QByteArray JsonReaderTest::nested(int depth)
+{
+	// alternates objects and arrays, like {"a":[{"a":[...]}]}
+	QByteArray json;
+	for(auto i = 0; i < depth; ++i)
+		json.append(i % 2 == 0 ? "{\"a\":" : "[");
+	json.append("null");
+	for(auto i = depth - 1; i >= 0; --i)
+		json.append(i % 2 == 0 ? '}' : ']');
+	return json;
+}
+
+QTEST_GUILESS_MAIN(JsonReaderTest)
+
+#include "tst_jsonreader.moc"
@@ -0,0 +1,8 @@
+TEMPLATE = app
+
+TARGET = tst_jsonwriter
+
+include(../tests.pri)
+
+SOURCES += \
+	tst_jsonwriter.cpp
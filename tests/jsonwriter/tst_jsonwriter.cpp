@@ -0,0 +1,92 @@
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <jsonwriter_p.h>
+
+using namespace KPXCClient;
+
+class JsonWriterTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void testStrings_data();
+	void testStrings();
+	void testCompact();
+	void testRoundTrip();
+};
+
+void JsonWriterTest::testStrings_data()
+{
+	QTest::addColumn<QString>("text");
+	QTest::addColumn<QByteArray>("result");
+
+	QTest::newRow("plain") << QStringLiteral("abc")
+						   << QByteArray{"\"abc\""};
+	QTest::newRow("empty") << QString{}
+						   << QByteArray{"\"\""};
+	QTest::newRow("quotes") << QStringLiteral("a\"b\\c/")
+							<< QByteArray{"\"a\\\"b\\\\c/\""};
+	QTest::newRow("controls") << QStringLiteral("\b\f\n\r\t\x01\x1f")
+							  << QByteArray{"\"\\b\\f\\n\\r\\t\\u0001\\u001f\""};
+	QTest::newRow("twoBytes") << QString{QChar{0x00e9}}
+							  << QByteArray{"\"\xc3\xa9\""};
+	QTest::newRow("threeBytes") << QString{QChar{0x20ac}}
+								<< QByteArray{"\"\xe2\x82\xac\""};
+	QTest::newRow("surrogatePair") << QString::fromUtf8("\xf0\x9f\x98\x80")
+								   << QByteArray{"\"\xf0\x9f\x98\x80\""};
+	QTest::newRow("loneHigh") << QString{QChar{0xd83d}} + QLatin1Char('z')
+							  << QByteArray{"\"\xef\xbf\xbd" "z\""};
+	QTest::newRow("loneHighAtEnd") << QString{QChar{0xd83d}}
+								   << QByteArray{"\"\xef\xbf\xbd\""};
+	QTest::newRow("loneLow") << QString{QChar{0xde00}}
+							 << QByteArray{"\"\xef\xbf\xbd\""};
+}
+
+void JsonWriterTest::testStrings()
+{
+	QFETCH(QString, text);
+	QFETCH(QByteArray, result);
+
+	QByteArray json;
+	JsonWriter{json}.writeString(text);
+	QCOMPARE(json, result);
+}
+
+void JsonWriterTest::testCompact()
+{
+	const QJsonObject object {
+		{QStringLiteral("b"), QStringLiteral("c")},
+		{QStringLiteral("a"), QJsonArray{1, true, QJsonValue::Null, -2.5}},
+		{QStringLiteral("o"), QJsonObject{}}
+	};
+	QCOMPARE(JsonWriter::toJson(object), QByteArray{"{\"a\":[1,true,null,-2.5],\"b\":\"c\",\"o\":{}}"});
+}
+
+void JsonWriterTest::testRoundTrip()
+{
+	QString text;
+	for(ushort c = 0; c < 0x300; ++c)
+		text.append(QChar{c});
+	text.append(QString::fromUtf8("\xe2\x82\xac\xf0\x9f\x98\x80"));
+
+	const QJsonObject object {
+		{QStringLiteral("text"), text},
+		{QStringLiteral("numbers"), QJsonArray{0, -1, 42, 9007199254740991.0, 0.1, -1e-7, 1e300}},
+		{QStringLiteral("flags"), QJsonArray{true, false, QJsonValue::Null}},
+		{QStringLiteral("nested"), QJsonObject{
+			{QString::fromUtf8("k\xc3\xa9y"), QJsonArray{QJsonObject{}, QJsonArray{}}}
+		}}
+	};
+
+	QJsonParseError error;
+	const auto document = QJsonDocument::fromJson(JsonWriter::toJson(object), &error);
+	QCOMPARE(error.error, QJsonParseError::NoError);
+	QCOMPARE(document.object(), object);
+}
+
+QTEST_GUILESS_MAIN(JsonWriterTest)
+
+#include "tst_jsonwriter.moc"
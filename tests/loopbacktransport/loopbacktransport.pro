@@ -0,0 +1,8 @@
+TEMPLATE = app
+
+TARGET = tst_loopbacktransport
+
+include(../tests.pri)
+
+SOURCES += \
+	tst_loopbacktransport.cpp
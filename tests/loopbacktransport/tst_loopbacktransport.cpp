@@ -0,0 +1,120 @@
+#include <QtTest>
+
+#include <client.h>
+#include <loopbackserver.h>
+#include <mockserver.h>
+
+using namespace KPXCClient;
+
+class LoopbackTransportTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+
+	void testRequests_data();
+	void testRequests();
+	void testSecondClient();
+	void testClientDestroyed();
+	void testServerDestroyed();
+};
+
+void LoopbackTransportTest::initTestCase()
+{
+	QVERIFY(KPXCClient::init());
+}
+
+void LoopbackTransportTest::testRequests_data()
+{
+	QTest::addColumn<bool>("threaded");
+
+	QTest::newRow("direct") << false;
+	QTest::newRow("threaded") << true;
+}
+
+void LoopbackTransportTest::testRequests()
+{
+	QFETCH(bool, threaded);
+
+	LoopbackServer loopback;
+	MockServer mock;
+	mock.setEntryCount(2);
+	mock.attach(&loopback);
+
+	Client client;
+	if(threaded)
+		client.setOptions(client.options() | Client::Option::ThreadedConnection);
+	QSignalSpy errorSpy{&client, &Client::errorOccured};
+	QSignalSpy connectedSpy{&loopback, &LoopbackServer::connectedChanged};
+	client.connectToLoopback(&loopback);
+	QTRY_VERIFY_WITH_TIMEOUT(client.state() == Client::State::Unlocked, 5000);
+	QVERIFY(loopback.isConnected());
+
+	const auto future = client.getLoginsAsync(QUrl{QStringLiteral("https://example.com")});
+	QTRY_VERIFY_WITH_TIMEOUT(future.isFinished(), 5000);
+	QCOMPARE(future.result().size(), 2);
+
+	client.disconnectFromKeePass();
+	QTRY_VERIFY_WITH_TIMEOUT(client.state() == Client::State::Disconnected, 5000);
+	QTRY_COMPARE_WITH_TIMEOUT(connectedSpy.size(), 2, 5000);
+	QCOMPARE(connectedSpy[1][0].toBool(), false);
+	QVERIFY(!loopback.isConnected());
+	QVERIFY(errorSpy.isEmpty());
+}
+
+void LoopbackTransportTest::testSecondClient()
+{
+	LoopbackServer loopback;
+	MockServer mock;
+	mock.attach(&loopback);
+
+	Client first;
+	first.connectToLoopback(&loopback);
+	QTRY_VERIFY_WITH_TIMEOUT(first.state() == Client::State::Unlocked, 5000);
+
+	Client second;
+	QSignalSpy disconnectedSpy{&second, &Client::disconnected};
+	second.connectToLoopback(&loopback);
+	QTRY_COMPARE_WITH_TIMEOUT(disconnectedSpy.size(), 1, 5000);
+	QVERIFY(first.state() == Client::State::Unlocked);
+}
+
+void LoopbackTransportTest::testClientDestroyed()
+{
+	LoopbackServer loopback;
+	MockServer mock;
+	mock.attach(&loopback);
+
+	QSignalSpy connectedSpy{&loopback, &LoopbackServer::connectedChanged};
+	{
+		Client client;
+		client.connectToLoopback(&loopback);
+		QTRY_VERIFY_WITH_TIMEOUT(client.state() == Client::State::Unlocked, 5000);
+	}
+
+	// the server is notified although the transport is already gone
+	QTRY_COMPARE_WITH_TIMEOUT(connectedSpy.size(), 2, 5000);
+	QCOMPARE(connectedSpy[1][0].toBool(), false);
+	QVERIFY(!loopback.isConnected());
+}
+
+void LoopbackTransportTest::testServerDestroyed()
+{
+	QScopedPointer<LoopbackServer> loopback{new LoopbackServer{}};
+	MockServer mock;
+	mock.attach(loopback.data());
+
+	Client client;
+	QSignalSpy disconnectedSpy{&client, &Client::disconnected};
+	client.connectToLoopback(loopback.data());
+	QTRY_VERIFY_WITH_TIMEOUT(client.state() == Client::State::Unlocked, 5000);
+
+	loopback.reset();
+	QTRY_COMPARE_WITH_TIMEOUT(disconnectedSpy.size(), 1, 5000);
+	QVERIFY(client.state() == Client::State::Disconnected);
+}
+
+QTEST_GUILESS_MAIN(LoopbackTransportTest)
+
+#include "tst_loopbacktransport.moc"
@@ -0,0 +1,8 @@
+TEMPLATE = app
+
+TARGET = tst_noncewindow
+
+include(../tests.pri)
+
+SOURCES += \
+	tst_noncewindow.cpp
@@ -0,0 +1,161 @@
+#include <QtTest>
+#include <QtEndian>
+
+#include <noncewindow_p.h>
+
+using namespace KPXCClient;
+
+class NonceWindowTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void testInsertTake();
+	void testCollisions_data();
+	void testCollisions();
+	void testFull();
+	void testTakeOldest();
+	void testExpire();
+
+private:
+	static NonceWindow::Nonce nonce(quint32 home, quint8 id);
+	static NonceWindow::Clock::time_point later();
+};
+
+void NonceWindowTest::testInsertTake()
+{
+	NonceWindow window;
+	QVERIFY(window.isEmpty());
+	window.insert(nonce(1, 1), {1, QStringLiteral("a")}, later());
+	window.insert(nonce(2, 2), {2, QStringLiteral("b")}, later());
+	QCOMPARE(window.size(), 2);
+
+	QCOMPARE(window.take(nonce(3, 3)).id, quint64{0});
+	const auto request = window.take(nonce(2, 2));
+	QCOMPARE(request.id, quint64{2});
+	QCOMPARE(request.action, QStringLiteral("b"));
+	QCOMPARE(window.take(nonce(2, 2)).id, quint64{0});
+	QCOMPARE(window.take(nonce(1, 1)).id, quint64{1});
+	QVERIFY(window.isEmpty());
+}
+
+void NonceWindowTest::testCollisions_data()
+{
+	QTest::addColumn<quint32>("home");
+
+	QTest::newRow("middle") << 5u;
+	QTest::newRow("wrapped") << 510u;
+}
+
+void NonceWindowTest::testCollisions()
+{
+	QFETCH(quint32, home);
+
+	// 1-3 share a home slot, 4 is displaced by them from the following one
+	NonceWindow window;
+	window.insert(nonce(home, 1), {1, {}}, later());
+	window.insert(nonce(home, 2), {2, {}}, later());
+	window.insert(nonce(home, 3), {3, {}}, later());
+	window.insert(nonce(home + 1, 4), {4, {}}, later());
+
+	// removing from the middle of the chain must keep the later entries reachable
+	QCOMPARE(window.take(nonce(home, 2)).id, quint64{2});
+	QCOMPARE(window.take(nonce(home + 1, 4)).id, quint64{4});
+	QCOMPARE(window.take(nonce(home, 3)).id, quint64{3});
+	QCOMPARE(window.take(nonce(home, 1)).id, quint64{1});
+	QVERIFY(window.isEmpty());
+
+	// removing the head moves the rest of the chain forward
+	window.insert(nonce(home, 1), {1, {}}, later());
+	window.insert(nonce(home + 1, 4), {4, {}}, later());
+	window.insert(nonce(home, 2), {2, {}}, later());
+	QCOMPARE(window.take(nonce(home, 1)).id, quint64{1});
+	QCOMPARE(window.take(nonce(home, 2)).id, quint64{2});
+	QCOMPARE(window.take(nonce(home + 1, 4)).id, quint64{4});
+	QVERIFY(window.isEmpty());
+}
+
+void NonceWindowTest::testFull()
+{
+	// all requests collide to get the longest possible probe sequences
+	NonceWindow window;
+	for(auto i = 0; i < NonceWindow::Capacity; ++i) {
+		QVERIFY(!window.isFull());
+		auto key = nonce(7, 0);
+		key[0] = static_cast<quint8>(i);
+		window.insert(key, {static_cast<quint64>(i + 1), {}}, later());
+	}
+	QVERIFY(window.isFull());
+	QCOMPARE(window.size(), NonceWindow::Capacity);
+
+	for(auto i = 0; i < NonceWindow::Capacity; i += 2) {
+		auto key = nonce(7, 0);
+		key[0] = static_cast<quint8>(i);
+		QCOMPARE(window.take(key).id, static_cast<quint64>(i + 1));
+	}
+	QVERIFY(!window.isFull());
+	for(auto i = 1; i < NonceWindow::Capacity; i += 2) {
+		auto key = nonce(7, 0);
+		key[0] = static_cast<quint8>(i);
+		QCOMPARE(window.take(key).id, static_cast<quint64>(i + 1));
+	}
+	QVERIFY(window.isEmpty());
+}
+
+void NonceWindowTest::testTakeOldest()
+{
+	NonceWindow window;
+	window.insert(nonce(1, 1), {3, QStringLiteral("a")}, later());
+	window.insert(nonce(2, 2), {1, QStringLiteral("b")}, later());
+	window.insert(nonce(3, 3), {2, QStringLiteral("a")}, later());
+
+	QCOMPARE(window.takeOldest(QStringLiteral("a")).id, quint64{2});
+	QCOMPARE(window.takeOldest(QStringLiteral("a")).id, quint64{3});
+	QCOMPARE(window.takeOldest(QStringLiteral("a")).id, quint64{0});
+	QCOMPARE(window.size(), 1);
+}
+
+void NonceWindowTest::testExpire()
+{
+	const auto now = NonceWindow::Clock::now();
+	NonceWindow window;
+	window.insert(nonce(1, 1), {1, {}}, now);
+	window.insert(nonce(1, 2), {2, {}}, later());
+	window.insert(nonce(1, 3), {3, {}}, now);
+
+	QList<quint64> expired;
+	window.expire(now, [&](NonceWindow::Request request) {
+		expired.append(request.id);
+	});
+	std::sort(expired.begin(), expired.end());
+	QCOMPARE(expired, (QList<quint64>{1, 3}));
+	QCOMPARE(window.size(), 1);
+	QCOMPARE(window.take(nonce(1, 2)).id, quint64{2});
+
+	// each late reply is recognized once, pending or unknown nonces never
+	QVERIFY(window.takeTombstone(nonce(1, 1)));
+	QVERIFY(!window.takeTombstone(nonce(1, 1)));
+	QVERIFY(!window.takeTombstone(nonce(1, 2)));
+	QVERIFY(!window.takeTombstone(nonce(4, 4)));
+
+	window.clear();
+	QVERIFY(!window.takeTombstone(nonce(1, 3)));
+}
+
+NonceWindow::Nonce NonceWindowTest::nonce(quint32 home, quint8 id)
+{
+	// the home slot is taken from bytes 8 to 11
+	NonceWindow::Nonce nonce{};
+	nonce[0] = id;
+	qToUnaligned(home, nonce.data() + 8);
+	return nonce;
+}
+
+NonceWindow::Clock::time_point NonceWindowTest::later()
+{
+	return NonceWindow::Clock::now() + std::chrono::hours{1};
+}
+
+QTEST_GUILESS_MAIN(NonceWindowTest)
+
+#include "tst_noncewindow.moc"
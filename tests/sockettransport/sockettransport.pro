@@ -0,0 +1,8 @@
+TEMPLATE = app
+
+TARGET = tst_sockettransport
+
+include(../tests.pri)
+
+SOURCES += \
+	tst_sockettransport.cpp
@@ -0,0 +1,124 @@
+#include <QtTest>
+#include <QCoreApplication>
+
+#include <client.h>
+#include <mockserver.h>
+#include <jsonstreamdecoder_p.h>
+
+using namespace KPXCClient;
+
+class SocketTransportTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+
+	void testRequests();
+	void testMissingServer();
+
+	void testDecoderChunks();
+	void testDecoderStrings();
+	void testDecoderInvalid();
+
+private:
+	static QString serverName();
+	static QList<QByteArray> decode(JsonStreamDecoder &decoder, const QByteArray &data);
+};
+
+void SocketTransportTest::initTestCase()
+{
+	QVERIFY(KPXCClient::init());
+}
+
+void SocketTransportTest::testRequests()
+{
+	MockServer mock;
+	mock.setEntryCount(3);
+	QVERIFY(mock.listen(serverName()));
+
+	Client client;
+	QSignalSpy errorSpy{&client, &Client::errorOccured};
+	QSignalSpy disconnectedSpy{&client, &Client::disconnected};
+	client.connectToSocket(serverName());
+	QTRY_VERIFY_WITH_TIMEOUT(client.state() == Client::State::Unlocked, 5000);
+
+	const auto future = client.getLoginsAsync(QUrl{QStringLiteral("https://example.com")});
+	QTRY_VERIFY_WITH_TIMEOUT(future.isFinished(), 5000);
+	QCOMPARE(future.result().size(), 3);
+
+	client.disconnectFromKeePass();
+	QTRY_COMPARE_WITH_TIMEOUT(disconnectedSpy.size(), 1, 5000);
+	QVERIFY(client.state() == Client::State::Disconnected);
+	QVERIFY(errorSpy.isEmpty());
+}
+
+void SocketTransportTest::testMissingServer()
+{
+	Client client;
+	QSignalSpy disconnectedSpy{&client, &Client::disconnected};
+	client.connectToSocket(serverName() + QStringLiteral("-missing"));
+	QTRY_COMPARE_WITH_TIMEOUT(disconnectedSpy.size(), 1, 5000);
+	QVERIFY(client.state() == Client::State::Disconnected);
+}
+
+void SocketTransportTest::testDecoderChunks()
+{
+	JsonStreamDecoder decoder;
+	QCOMPARE(decode(decoder, "{\"a\":[1,"), QList<QByteArray>{});
+	QCOMPARE(decode(decoder, "{\"b\":2}]}\n {\"c\":3}{"),
+			 (QList<QByteArray>{"{\"a\":[1,{\"b\":2}]}", "{\"c\":3}"}));
+	QCOMPARE(decode(decoder, "}"), QList<QByteArray>{"{}"});
+	QCOMPARE(decoder.bufferedBytes(), qint64{0});
+}
+
+void SocketTransportTest::testDecoderStrings()
+{
+	JsonStreamDecoder decoder;
+	QCOMPARE(decode(decoder, "{\"a\":\"}{]\\\"\"}"),
+			 QList<QByteArray>{"{\"a\":\"}{]\\\"\"}"});
+}
+
+void SocketTransportTest::testDecoderInvalid()
+{
+	JsonStreamDecoder decoder;
+	QByteArray frame;
+	const QByteArray garbage{"x{}"};
+	memcpy(decoder.reserve(garbage.size()), garbage.constData(), static_cast<size_t>(garbage.size()));
+	decoder.commit(garbage.size());
+	QCOMPARE(decoder.nextFrame(frame), FrameDecoder::Result::Invalid);
+	QCOMPARE(decoder.bufferedBytes(), qint64{0});
+
+	// an object that never ends is rejected once it exceeds the frame limit
+	const QByteArray chunk(64 * 1024, ' ');
+	memcpy(decoder.reserve(1), "{", 1);
+	decoder.commit(1);
+	auto result = FrameDecoder::Result::Incomplete;
+	for(qint64 size = 1; size <= FrameDecoder::MaxFrameSize + chunk.size() && result == FrameDecoder::Result::Incomplete; size += chunk.size()) {
+		memcpy(decoder.reserve(chunk.size()), chunk.constData(), static_cast<size_t>(chunk.size()));
+		decoder.commit(chunk.size());
+		result = decoder.nextFrame(frame);
+	}
+	QCOMPARE(result, FrameDecoder::Result::Invalid);
+}
+
+QString SocketTransportTest::serverName()
+{
+	return QStringLiteral("kpxcclient-test-%1").arg(QCoreApplication::applicationPid());
+}
+
+QList<QByteArray> SocketTransportTest::decode(JsonStreamDecoder &decoder, const QByteArray &data)
+{
+	memcpy(decoder.reserve(data.size()), data.constData(), static_cast<size_t>(data.size()));
+	decoder.commit(data.size());
+
+	QList<QByteArray> frames;
+	QByteArray frame;
+	while(decoder.nextFrame(frame) == FrameDecoder::Result::Frame)
+		frames.append(QByteArray{frame.constData(), frame.size()});
+	return frames;
+}
+
+QTEST_GUILESS_MAIN(SocketTransportTest)
+
+#include "tst_sockettransport.moc"
@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+	sockettransport \
+	loopbacktransport \
+	jsonreader \
+	jsonwriter \
+	noncewindow